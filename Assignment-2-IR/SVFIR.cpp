@@ -5,13 +5,102 @@
 
 #include "Graphs/SVFG.h"
 #include "SVF-LLVM/SVFIRBuilder.h"
+#include "Profiler.h"
+#include <cstdio>
+#include <future>
+#include <sstream>
 
 using namespace SVF;
 using namespace llvm;
 using namespace std;
 
+static Option<std::string> GraphExport("graph-export",
+                                       "Comma-separated export formats: dot, edges (text edge list), bin (binary edge list)",
+                                       "dot");
+
+/**
+ * Write the edges of a graph as an edge list through a large buffer.
+ * Text: one "src dst kind" line per edge.
+ * Binary: the magic "SVFE", the u32 node and edge counts, then one u32 (src, dst, kind) triple per edge,
+ * all in host byte order.
+ */
+template<class GraphType>
+static void writeEdgeList(GraphType *graph, const std::string &fname, bool binary)
+{
+    FILE *file = std::fopen(fname.c_str(), "wb");
+    if (!file)
+    {
+        cout << "error opening " + fname + "!!\n";
+        return;
+    }
+
+    std::vector<char> buffer;
+    buffer.reserve(1 << 20);
+    auto flush = [&]() {
+        std::fwrite(buffer.data(), 1, buffer.size(), file);
+        buffer.clear();
+    };
+    auto putU32 = [&](u32_t value) {
+        const char *bytes = reinterpret_cast<const char *>(&value);
+        buffer.insert(buffer.end(), bytes, bytes + sizeof(value));
+    };
+
+    if (binary)
+    {
+        u32_t numEdges = 0;
+        for (auto &it : *graph)
+            numEdges += it.second->getOutEdges().size();
+        buffer.insert(buffer.end(), {'S', 'V', 'F', 'E'});
+        putU32(graph->getTotalNodeNum());
+        putU32(numEdges);
+    }
+
+    for (auto &it : *graph)
+    {
+        for (auto *edge : it.second->getOutEdges())
+        {
+            if (binary)
+            {
+                putU32(edge->getSrcID());
+                putU32(edge->getDstID());
+                putU32(edge->getEdgeKind());
+            }
+            else
+            {
+                std::string line = std::to_string(edge->getSrcID()) + ' ' + std::to_string(edge->getDstID()) + ' ' +
+                                   std::to_string(edge->getEdgeKind()) + '\n';
+                buffer.insert(buffer.end(), line.begin(), line.end());
+            }
+            if (buffer.size() >= (1 << 20))
+                flush();
+        }
+    }
+    flush();
+    std::fclose(file);
+}
+
+/// Dump one graph as a dot file; the printer goes through LLVM value printing and is run on one thread only
+template<class GraphType>
+static void exportDot(GraphType *graph, const std::string &prefix)
+{
+    ProfilePhase phase("export dot", prefix);
+    graph->dump(prefix);   // dump() appends the .dot extension
+}
+
+/// Write the requested edge lists of one graph; they only read node ids and edge kinds, so graphs may run concurrently
+template<class GraphType>
+static void exportEdgeLists(GraphType *graph, const std::string &prefix, const std::set<std::string> &formats)
+{
+    ProfilePhase phase("export edge lists", prefix);
+    if (formats.count("edges"))
+        writeEdgeList(graph, prefix + ".edges", false);
+    if (formats.count("bin"))
+        writeEdgeList(graph, prefix + ".bin", true);
+}
+
 int main(int argc, char** argv)
 {
+    ProfilePhase parsePhase("parse options");
     int arg_num = 0;
     int extraArgc = 4;
     char** arg_value = new char*[argc + extraArgc];
@@ -28,8 +117,12 @@ int main(int argc, char** argv)
     assert(arg_num == (orgArgNum + extraArgc) && "more extra arguments? Change the value of extraArgc");
 
     moduleNameVec = OptionBase::parseOptions(arg_num, arg_value, "SVF IR", "[options] <input-bitcode...>");
+    Profiler::getProfiler().configure();
+    parsePhase.stop();
 
+    ProfilePhase loadPhase("load bitcode");
     LLVMModuleSet::getLLVMModuleSet()->buildSVFModule(moduleNameVec);
+    loadPhase.stop();
 
     // Instantiate an SVFIR builder
     SVFIRBuilder builder;
@@ -38,7 +131,9 @@ int main(int argc, char** argv)
     // TODO: here, generate SVFIR(PAG), call graph and ICFG, and dump them to files
     //@{
     // 1. 生成SVFIR（即程序赋值图PAG）：SVFIRBuilder::build()返回PAG实例
+    ProfilePhase buildPhase("build SVFIR");
     auto pag = builder.build();
+    buildPhase.stop();
     
     // 2. 从PAG中获取调用图（CG）和跨过程控制流图（ICFG）：
     const CallGraph* callGraph = pag->getCallGraph();  // 获取函数调用关系图
@@ -50,15 +145,42 @@ int main(int argc, char** argv)
     size_t lastSlash = inputFile.find_last_of("/\\");
     string fileName = (lastSlash == string::npos) ? inputFile : inputFile.substr(lastSlash + 1);
     
-    // 4. 导出图为Dot文件
+    // 4. 导出图：dot 文件经 SVF 的 GraphPrinter 与 LLVM 的 Value 打印生成，二者并非线程安全，故依次导出；
+    //    边表只读取节点编号和边类型，三个图各由一个线程并发写出
     // 注意：dump 方法的参数是文件名前缀，会自动添加 .dot 扩展名
-    pag->dump(fileName + ".pag");                      // 导出PAG（程序赋值图），生成 .pag.dot 文件
-    const_cast<CallGraph*>(callGraph)->dump(fileName + ".cg");  // 导出CallGraph（调用图），生成 .cg.dot 文件
-    interCFG->dump(fileName + ".icfg");                 // 导出ICFG（跨过程控制流图），生成 .icfg.dot 文件
+    std::set<std::string> formats;
+    std::stringstream formatList(GraphExport());
+    for (std::string format; std::getline(formatList, format, ',');)
+        formats.insert(format);
+
+    if (formats.count("dot"))
+    {
+        exportDot(pag, fileName + ".pag");                                  // PAG（程序赋值图）
+        exportDot(const_cast<CallGraph*>(callGraph), fileName + ".cg");     // CallGraph（调用图）
+        exportDot(interCFG, fileName + ".icfg");                            // ICFG（跨过程控制流图）
+    }
+
+    if (formats.count("edges") || formats.count("bin"))
+    {
+        ProfilePhase edgePhase("export edge lists");
+        std::vector<std::future<void>> exports;
+        exports.push_back(std::async(std::launch::async, [&]() {
+            exportEdgeLists(pag, fileName + ".pag", formats);
+        }));
+        exports.push_back(std::async(std::launch::async, [&]() {
+            exportEdgeLists(const_cast<CallGraph*>(callGraph), fileName + ".cg", formats);
+        }));
+        exports.push_back(std::async(std::launch::async, [&]() {
+            exportEdgeLists(interCFG, fileName + ".icfg", formats);
+        }));
+        for (auto &task : exports)
+            task.get();
+    }
     
     // 5. 释放资源（SVFIR 会管理其内部资源）
     //@}
     delete[] arg_value;
 
+    Profiler::getProfiler().finish();
     return 0;
 }
@@ -4,44 +4,138 @@
  */
 
 #include "CFGA.h"
+#include "Cache.h"
+#include "Profiler.h"
+#include <sstream>
 
 using namespace SVF;
 using namespace llvm;
 using namespace std;
 
+static ToolOption<u32_t> PathThreads("path-threads", "Number of threads searching paths (1: sequential)", 1);
+static ToolOption<std::string> SourcePatterns("path-sources",
+                                              "Comma-separated source patterns ([entry:|exit:|call:]name-or-regex)", "main");
+static ToolOption<std::string> SinkPatterns("path-sinks",
+                                            "Comma-separated sink patterns ([entry:|exit:|call:]name-or-regex)", "main");
+static ToolOption<std::string> EndpointFile("endpoint-file",
+                                            "File of \"source <pattern>\" and \"sink <pattern>\" lines and # comments, "
+                                            "added to the above", "");
+static ToolOption<u32_t> MaxPaths("max-paths", "Stop after this many paths (0: no limit)", 0);
+static ToolOption<u32_t> MaxPathLength("max-path-length", "Do not extend paths beyond this many nodes (0: no limit)", 0);
+static ToolOption<u32_t> PathTimeLimit("path-time-limit", "Stop searching paths after this many seconds (0: no limit)", 0);
+static ToolOption<std::string> StreamPaths("stream-paths",
+                                           "Write paths as they are found instead of keeping them (text or binary)", "");
+static ToolOption<std::string> CacheDir("cache-dir", "Directory caching the ICFG built from bitcode (empty: no cache)", "");
+
+/// Split a comma-separated option value into patterns
+static void splitPatterns(const std::string &list, std::vector<std::string> &patterns)
+{
+    std::stringstream ss(list);
+    for (std::string item; std::getline(ss, item, ',');)
+    {
+        if (!item.empty())
+            patterns.push_back(item);
+    }
+}
+
 int main(int argc, char **argv)
 {
+    ProfilePhase parsePhase("parse options");
     auto moduleNameVec =
             OptionBase::parseOptions(argc, argv, "Whole Program Points-to Analysis",
                                      "[options] <input-bitcode...>");
+    Profiler::getProfiler().configure();
+    parsePhase.stop();
+
+    if (!StreamPaths().empty() && StreamPaths() != "text" && StreamPaths() != "binary")
+    {
+        std::cout << "unknown -stream-paths format " + StreamPaths() + " (expected text or binary)\n";
+        return 1;
+    }
+
+    // A cache hit restores the snapshot and the function index and skips LLVM parsing and SVFIR construction
+    // An unusable cache directory disables the cache
+    std::string cacheDir = CacheDir();
+    if (!cacheDir.empty() && !createCacheDir(cacheDir))
+        cacheDir.clear();
+    ICFGCache cache(cacheDir, moduleNameVec, svfOptions(argc, argv));
+    std::string moduleName;
+    ICFGSnapshot snapshot;
+    FunctionIndex index;
+    ProfilePhase cachePhase("load cached graph");
+    bool fromCache = cache.load(moduleName, snapshot, index);
+    cachePhase.stop();
+    if (!fromCache)
+    {
+        ProfilePhase loadPhase("load bitcode");
+        LLVMModuleSet::buildSVFModule(moduleNameVec);
+        loadPhase.stop();
+
+        ProfilePhase buildPhase("build SVFIR");
+        SVFIRBuilder builder;
+        auto pag = builder.build();
+        auto icfg = pag->getICFG();
+        buildPhase.stop();
+
+        ProfilePhase graphPhase("build graph");
+        moduleName = pag->getModuleIdentifier();
+        snapshot = ICFGSnapshot(icfg);
+        index = FunctionIndex(pag->getCallGraph(), icfg);
+        cache.store(moduleName, snapshot, index);
+        graphPhase.stop();
+    }
 
-    LLVMModuleSet::buildSVFModule(moduleNameVec);
+    std::vector<std::string> sourcePatterns, sinkPatterns;
+    splitPatterns(SourcePatterns(), sourcePatterns);
+    splitPatterns(SinkPatterns(), sinkPatterns);
+    if (!EndpointFile().empty() && !FunctionIndex::readEndpointFile(EndpointFile(), sourcePatterns, sinkPatterns))
+        return 1;
 
-    SVFIRBuilder builder;
-    auto pag = builder.build();
-    auto icfg = pag->getICFG();
+    CFGAnalysis analyzer = CFGAnalysis(std::move(snapshot), index, sourcePatterns, sinkPatterns);
+    analyzer.setNumThreads(PathThreads());
 
-    CFGAnalysis analyzer = CFGAnalysis(icfg);
+    PathBudget budget;
+    budget.maxPaths = MaxPaths();
+    budget.maxLength = MaxPathLength();
+    budget.maxSeconds = PathTimeLimit();
+    analyzer.setPathBudget(budget);
 
-    // TODO: complete the following method: 'CFGAnalysis::analyze'
-    analyzer.analyze(icfg);
+    if (!StreamPaths().empty())
+    {
+        bool binary = StreamPaths() == "binary";
+        std::string fname = moduleName + (binary ? ".res.bin" : ".res.txt");
+        StreamPathSink sink(fname, binary ? StreamPathSink::Binary : StreamPathSink::Text);
+        if (!sink.isOpen())
+        {
+            std::cout << "error opening " + fname + "!!\n";
+            return 1;
+        }
+        analyzer.setPathSink(&sink);
+        ProfilePhase analyzePhase("analyze");
+        analyzer.analyze();
+        sink.close();
+    }
+    else
+    {
+        ProfilePhase analyzePhase("analyze");
+        // TODO: complete the following method: 'CFGAnalysis::analyze'
+        analyzer.analyze();
+        analyzePhase.stop();
 
-    analyzer.dumpPaths();
-    LLVMModuleSet::releaseLLVMModuleSet();
+        ProfilePhase dumpPhase("dump");
+        analyzer.dumpPaths(moduleName + ".res.txt");
+    }
+
+    if (!fromCache)
+        LLVMModuleSet::releaseLLVMModuleSet();
+    Profiler::getProfiler().finish();
     return 0;
 }
 
-
 void CFGAnalysis::analyze(SVF::ICFG *icfg)
 {
     // Sources and sinks are specified when an analyzer is instantiated.
-    for (auto src : sources)
-        for (auto snk : sinks)
-        {
-            // TODO: DFS the graph, starting from src and detecting the paths ending at snk.
-            // Use the class method 'recordPath' (already defined) to record the path you detected.
-            //@{
-
-            //@}
-        }
+    graph = ICFGSnapshot(icfg);
+    analyzeGraph();
 }
+
@@ -8,21 +8,555 @@
 
 #include "Graphs/SVFG.h"
 #include "SVF-LLVM/SVFIRBuilder.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <regex>
+#include <functional>
+#include <mutex>
+
+/**
+ * Receiver of the paths found by a path search
+ */
+class PathSink
+{
+public:
+    virtual ~PathSink() = default;
+
+    /// Take one path; the vector is only valid during the call
+    virtual void consume(const std::vector<unsigned> &path) = 0;
+};
+
+
+/**
+ * A set of paths stored as a trie, so paths sharing a prefix share its nodes.
+ * Iteration expands the paths lazily, one at a time, in lexicographic order.
+ */
+class PathTrie : public PathSink
+{
+    struct TrieNode
+    {
+        unsigned label;         // ICFG node id (unused for the root)
+        unsigned firstChild;    // children form a sibling list sorted by label
+        unsigned nextSibling;
+        bool terminal;          // a recorded path ends here
+    };
+
+    static constexpr unsigned None = ~0u;
+
+public:
+    class const_iterator
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = std::vector<unsigned>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const std::vector<unsigned> *;
+        using reference = const std::vector<unsigned> &;
+
+        reference operator*() const
+        { return path; }
+
+        pointer operator->() const
+        { return &path; }
+
+        const_iterator &operator++()
+        {
+            advance();
+            return *this;
+        }
+
+        bool operator==(const const_iterator &rhs) const
+        { return stack == rhs.stack; }
+
+        bool operator!=(const const_iterator &rhs) const
+        { return !(*this == rhs); }
+
+    private:
+        friend class PathTrie;
+
+        /// Move to the next recorded path in preorder
+        void advance();
+        /// Move to the next trie node in preorder; false at the end
+        bool step();
+
+        const PathTrie *trie = nullptr;
+        std::vector<unsigned> stack;   // trie nodes from the root to the current one
+        std::vector<unsigned> path;    // labels along 'stack', excluding the root
+    };
+
+    PathTrie()
+    { clear(); }
+
+    /// Insert a path; returns false if it is empty or already present
+    bool insert(const std::vector<unsigned> &path);
+
+    void consume(const std::vector<unsigned> &path) override
+    { insert(path); }
+
+    /// Number of distinct paths, available without enumerating them
+    size_t size() const
+    { return numPaths; }
+
+    bool empty() const
+    { return numPaths == 0; }
+
+    void clear();
+
+    /// Insert every path of another trie
+    void merge(const PathTrie &other);
+
+    const_iterator begin() const;
+
+    const_iterator end() const
+    { return const_iterator(); }
+
+private:
+    /// Find or create the child of 'parent' labelled 'label'
+    unsigned getChild(unsigned parent, unsigned label);
+
+    std::vector<TrieNode> nodes;   // nodes[0] is the root
+    size_t numPaths = 0;
+};
+
+
+/**
+ * Writes paths to a file as they are found, through a large output buffer.
+ * The search emits every path once, so paths are written as they come, without deduplication.
+ * Safe to share between threads.
+ *
+ * Text format: one path per line, "n1, n2, ..., " as produced by dumpPaths.
+ * Binary format: the magic "CFGP", then per path the varint node count, the first node id as a varint
+ * and every further node as a zigzag varint delta from its predecessor.
+ */
+class StreamPathSink : public PathSink
+{
+public:
+    enum Format
+    {
+        Text, Binary
+    };
+
+    StreamPathSink(const std::string &fname, Format format);
+
+    ~StreamPathSink() override
+    { close(); }
+
+    bool isOpen() const
+    { return file != nullptr; }
+
+    void consume(const std::vector<unsigned> &path) override;
+
+    /// Flush the buffer and close the file
+    void close();
+
+    /// Number of paths written
+    size_t size() const
+    { return numPaths; }
+
+private:
+    static constexpr size_t BufferSize = 1 << 20;
+
+    void writeVarint(uint64_t value);
+    void flush();
+
+    std::mutex lock;
+    FILE *file;
+    Format format;
+    std::vector<char> buffer;
+    size_t numPaths = 0;
+};
+
+
+/**
+ * A dense, read-only copy of an ICFG for path search.
+ * Nodes get compact ids 0..n-1 and successors are stored in one CSR array,
+ * so a search touches contiguous memory instead of ICFG node and edge objects.
+ */
+class ICFGSnapshot
+{
+public:
+    enum EdgeKind : uint8_t
+    {
+        IntraEdge, CallEdge, RetEdge
+    };
+
+    struct Edge
+    {
+        unsigned dst;    // compact id of the target
+        unsigned aux;    // call edge: compact id of the return site; return edge: compact id of the call site
+        EdgeKind kind;
+    };
+
+    static constexpr unsigned None = ~0u;
+
+    ICFGSnapshot() = default;
+
+    /// Copy an ICFG
+    explicit ICFGSnapshot(SVF::ICFG *icfg);
+
+    /// Add a node by its ICFG id; all nodes must be added before finalize()
+    void addNode(unsigned id, bool isFunExit);
+    /// Add an edge between ICFG ids; 'aux' is the ICFG id described in Edge, or None
+    void addEdge(unsigned src, unsigned dst, EdgeKind kind, unsigned aux = None);
+    /// Translate the added edges to compact ids and lay them out in CSR form
+    void finalize();
+
+    /// Write a finalized snapshot in binary form
+    void write(std::ostream &out) const;
+    /// Replace the contents by a snapshot written by write(); false if the data is truncated
+    bool read(std::istream &in);
+
+    /// Copy keeping only the nodes from which at least one of 'targets' (ICFG ids) is reachable
+    ICFGSnapshot pruneTo(const std::set<unsigned> &targets) const;
+
+    unsigned getNumNodes() const
+    { return ids.size(); }
+
+    size_t getNumEdges() const
+    { return edges.size(); }
+
+    /// Compact id of an ICFG node, or None if it is not in the snapshot
+    unsigned getCompactId(unsigned id) const
+    {
+        auto it = compactIds.find(id);
+        return it == compactIds.end() ? None : it->second;
+    }
+
+    /// ICFG id of a compact node
+    unsigned getId(unsigned node) const
+    { return ids[node]; }
+
+    bool isFunExit(unsigned node) const
+    { return funExit[node]; }
+
+    const Edge *succBegin(unsigned node) const
+    { return edges.data() + offsets[node]; }
+
+    const Edge *succEnd(unsigned node) const
+    { return edges.data() + offsets[node + 1]; }
+
+private:
+    struct PendingEdge
+    {
+        unsigned src, dst, aux;
+        EdgeKind kind;
+    };
+
+    std::vector<unsigned> ids;                          // compact -> ICFG id
+    std::unordered_map<unsigned, unsigned> compactIds;  // ICFG id -> compact
+    std::vector<bool> funExit;
+    std::vector<unsigned> offsets;                      // CSR row starts, offsets[n] == edges.size()
+    std::vector<Edge> edges;
+    std::vector<PendingEdge> pending;                   // edges added since the last finalize()
+};
+
+
+/**
+ * Index from function names to their ICFG endpoints, built once from the call graph.
+ *
+ * Endpoint patterns have the form "[kind:]name": kind is entry, exit or call (the call sites invoking the
+ * function), and name is either an exact function name or, if it contains regex metacharacters, an
+ * ECMAScript regular expression that must match the whole name.
+ */
+class FunctionIndex
+{
+public:
+    enum EndpointKind
+    {
+        Entry, Exit, CallSite
+    };
+
+    struct Function
+    {
+        std::string name;
+        unsigned entry;   // ICFGSnapshot::None for declarations
+        unsigned exit;
+        std::vector<unsigned> callSites;
+    };
+
+    FunctionIndex() = default;
+
+    explicit FunctionIndex(SVF::CallGraph *callGraph, SVF::ICFG *icfg);
+
+    /**
+     * Add the ICFG ids a pattern designates to 'out'
+     * @param pattern the endpoint pattern
+     * @param defaultKind the kind used when the pattern has no "kind:" prefix
+     * @return false if the pattern is malformed
+     */
+    bool resolve(const std::string &pattern, EndpointKind defaultKind, std::set<unsigned> &out) const;
+
+    /**
+     * Append the patterns of an endpoint file: one "source <pattern>" or "sink <pattern>" per line; blank lines
+     * and '#' comments (at the start of a line or after whitespace) are skipped
+     * @return false, after reporting the file and line, if the file cannot be read or a line is malformed
+     */
+    static bool readEndpointFile(const std::string &fname, std::vector<std::string> &sourcePatterns,
+                                 std::vector<std::string> &sinkPatterns);
+
+    /// Write the index in binary form
+    void write(std::ostream &out) const;
+    /// Replace the contents by an index written by write(); false if the data is truncated
+    bool read(std::istream &in);
+
+private:
+    static void addEndpoints(const Function &fun, EndpointKind kind, std::set<unsigned> &out);
+
+    std::vector<Function> functions;
+    std::unordered_map<std::string, unsigned> byName;
+};
+
+
+/**
+ * On-disk cache of what the analysis takes from SVF: the module name, the ICFG snapshot and the function index.
+ * Entries are <dir>/<key>.cfga, where the key is an FNV-1a hash of the bitcode paths and contents and of the
+ * options given to SVF, so a hit can skip LLVM parsing and SVFIR construction altogether.
+ */
+class ICFGCache
+{
+public:
+    /// An empty 'dir' disables the cache, as does an unreadable input
+    ICFGCache(const std::string &dir, const std::vector<std::string> &inputs, const std::vector<std::string> &options);
+
+    bool isEnabled() const
+    { return !path.empty(); }
+
+    /// Fill the arguments from the cache entry; false on a miss or an invalid entry
+    bool load(std::string &moduleName, ICFGSnapshot &snapshot, FunctionIndex &index) const;
+
+    /// Write the cache entry
+    void store(const std::string &moduleName, const ICFGSnapshot &snapshot, const FunctionIndex &index) const;
+
+private:
+    std::string path;
+};
+
+
+/**
+ * Limits on a path enumeration; 0 means unlimited
+ */
+struct PathBudget
+{
+    size_t maxPaths = 0;      // stop after this many paths
+    size_t maxLength = 0;     // do not extend a path beyond this many nodes
+    double maxSeconds = 0;    // stop after this much time
+};
+
 
 class CFGAnalysis
 {
 public:
+    /// Analyze the paths from the entry of main to the exit of main
     explicit CFGAnalysis(SVF::ICFG *icfg);
+
+    /**
+     * Analyze the paths between configured endpoints (see FunctionIndex for the pattern syntax)
+     * @param sourcePatterns patterns of the sources; a bare name means the function's entry
+     * @param sinkPatterns patterns of the sinks; a bare name means the function's exit
+     */
+    CFGAnalysis(SVF::ICFG *icfg, const std::vector<std::string> &sourcePatterns,
+                const std::vector<std::string> &sinkPatterns);
+
+    /// Analyze a prebuilt snapshot, e.g. a synthetic one, between the given ICFG ids
+    CFGAnalysis(ICFGSnapshot snapshot, std::set<unsigned> sources, std::set<unsigned> sinks);
+
+    /// Analyze a prebuilt snapshot, e.g. a cached one, between the endpoints the patterns designate in 'index'
+    CFGAnalysis(ICFGSnapshot snapshot, const FunctionIndex &index, const std::vector<std::string> &sourcePatterns,
+                const std::vector<std::string> &sinkPatterns);
+
     void analyze(SVF::ICFG *icfg);
     void dumpPaths();
 
+    /// Search the paths of the snapshot given at construction
+    void analyze()
+    { analyzeGraph(); }
+
+    /// Dump the recorded paths into the given file
+    void dumpPaths(const std::string &fname);
+
+    /// Number of nodes pushed onto a search path so far, a measure of search work
+    size_t getNumVisited() const
+    { return nodesVisited.load(); }
+
+    class PathGenerator;
+
+    /// Limit the enumeration done by analyze(); count and time limits make it sequential
+    void setPathBudget(const PathBudget &b)
+    { budget = b; }
+
+    /// The pruned snapshot searched by the last analyze()
+    const ICFGSnapshot &getGraph() const
+    { return graph; }
+
+    /// Paths recorded so far; iterating expands them lazily
+    const PathTrie &getPaths() const
+    { return reachablePaths; }
+
+    /// Number of recorded paths, without enumerating them
+    size_t getNumPaths() const
+    { return reachablePaths.size(); }
+
+    /// Stream paths into 'sink' as they are found instead of keeping them (nullptr: keep them)
+    void setPathSink(PathSink *sink)
+    { pathSink = sink; }
+
+    /// Search paths with this many worker threads (1: sequential)
+    void setNumThreads(unsigned n)
+    { numThreads = std::max(1u, n); }
+
 protected:
-    void recordPath(const std::vector<unsigned> &path);
+    /// Entry->exit reachability summary of one function, computed once and reused at every call site
+    struct FunSummary
+    {
+        std::unordered_set<unsigned> reach;   // nodes reachable from the entry along matched paths
+        std::set<unsigned> callees;           // entries of the functions called from 'reach'
+        std::set<std::pair<unsigned, unsigned>> returnSites;   // (context, return node) pairs waiting on the exit
+        bool exitReachable = false;
+    };
+
+    /// The context of the nodes reached from the current source before any call is entered
+    static constexpr unsigned RootContext = ~0u;
+    /// Parallel searches split into subtasks at branches on the first this many nodes of a path
+    static constexpr unsigned SplitDepth = 16;
+
+    /**
+     * A pending call and the context it opened. A context is identified by the path position of the call that
+     * opened it (0 for the root), so comparing contexts costs O(1): one path never makes the same call twice
+     * from the same context (that state is already on the path), so equal ids on a path mean equal call stacks.
+     */
+    struct CallContext
+    {
+        unsigned callSite;   // compact id
+        unsigned id;
+    };
+
+    /// State of one depth-first path search over the snapshot; each worker owns the searches it runs
+    struct PathSearch
+    {
+        unsigned snk;                         // compact id
+        std::vector<CallContext> callStack;   // the pending calls, each call site at most once
+        std::vector<CallContext> popped;      // calls closed by the return edges on 'path', to be undone in order
+        std::vector<bool> onStack;            // compact id -> whether the call site is pending
+        std::vector<unsigned> path;           // ICFG ids, as recorded
+        std::unordered_set<uint64_t> visited;   // (node, context id) states on 'path'
+
+        PathSearch(unsigned snk, unsigned numNodes) : snk(snk), onStack(numNodes)
+        {}
+
+        unsigned context() const
+        { return callStack.empty() ? 0 : callStack.back().id; }
 
-    std::stack<unsigned> callStack;
+        /// The key of a node in the current context in 'visited'
+        uint64_t state(unsigned node) const
+        { return (uint64_t) node << 32 | context(); }
+    };
+
+    /// How taking an edge changed the call stack of a search
+    enum StackOp
+    {
+        NoOp, PushedCall, PoppedCall
+    };
+
+public:
+    /**
+     * Pull-based path enumeration with an explicit DFS stack: next() runs the search up to the next path
+     * and suspends there, so a client pays only for the paths it takes.
+     */
+    class PathGenerator
+    {
+    public:
+        /// Produce the next path (ICFG ids); false once the search is exhausted or over budget
+        bool next(std::vector<unsigned> &path);
+
+        /// Whether the search stopped because of the budget rather than running out of paths
+        bool isOverBudget() const
+        { return overBudget; }
+
+    private:
+        friend class CFGAnalysis;
+
+        struct Frame
+        {
+            unsigned node;
+            const ICFGSnapshot::Edge *next;   // next out-edge to try
+            const ICFGSnapshot::Edge *via;    // edge that entered this node, nullptr for the root
+            StackOp op;                       // call stack effect of 'via'
+        };
+
+        PathGenerator(const CFGAnalysis &analysis, const PathBudget &budget);
+
+        /// Start the search of the next (source, sink) pair; false if none is left
+        bool startNextPair();
+        /// Push a node onto the path; false if it is already on it or the path is at its length limit
+        bool enter(unsigned node, const ICFGSnapshot::Edge *via, StackOp op);
+        /// Pop the top node and undo the call stack effect of the edge that entered it
+        void leave();
+        /// A generator searching only below the top node, with this generator's path, call stack and budget
+        PathGenerator splitTop() const;
+
+        const CFGAnalysis *analysis;
+        PathBudget budget;
+        std::chrono::steady_clock::time_point deadline;
+        std::vector<std::pair<unsigned, unsigned>> pairs;
+        size_t nextPair = 0;
+        PathSearch search;
+        std::vector<Frame> frames;
+        std::function<void(PathGenerator &&)> onSplit;   // if set, receives the nodes entered at split depth
+        unsigned splitDepth = 0;    // nodes entered while the path is at most this long are split off
+        bool found = false;         // the path in 'search' ends at the sink and has not been returned yet
+        bool overBudget = false;
+        size_t numPaths = 0;
+        size_t numVisited = 0;
+        size_t steps = 0;
+    };
+
+protected:
+    /// Search the paths from 'sources' to 'sinks' in 'graph', after pruning it to the sinks
+    void analyzeGraph();
+    /// Prune 'graph' to the sinks, tabulate summaries and collect the reachable (source, sink) pairs
+    void prepareGraph();
+    /// Enumerate the paths of the pairs prepareGraph() collected lazily; the analyzer must outlive the generator
+    PathGenerator generatePaths(const PathBudget &budget = PathBudget()) const;
+
+    /// Tabulate the nodes reachable from src (compact id), computing the summaries of the functions it enters
+    void computeSummaries(unsigned src);
+    /**
+     * Whether a sink (compact id) is reachable from the last tabulated source, along a path whose calls and
+     * returns are matched (unmatched returns are allowed). Polynomial in the ICFG size, not in the path count.
+     */
+    bool isReachableCompact(unsigned snk) const;
+    /// Collect the contexts (function entries, or RootContext) from which snk (compact id) can be reached
+    void computeSinkContexts(unsigned snk);
+
+    /**
+     * Whether a search at cur may take 'edge'; if so, apply the edge's call stack effect and report it in op.
+     * A call from a call site that is already pending is refused, so recursion is unrolled at most once per call site.
+     */
+    bool takeEdge(unsigned cur, const ICFGSnapshot::Edge &edge, PathSearch &search, StackOp &op) const;
+    /// Undo the call stack effect of an edge taken by takeEdge
+    static void undoEdge(const ICFGSnapshot::Edge &edge, StackOp op, PathSearch &search);
+
+    /**
+     * Run the searches for all (source, sink) pairs (compact ids) on a work-stealing pool and merge their paths.
+     * Each task drives a PathGenerator that hands the nodes it enters near the root off as new tasks.
+     */
+    void searchParallel(const std::vector<std::pair<unsigned, unsigned>> &pairs);
+
+    std::vector<std::pair<unsigned, unsigned>> searchPairs;   // reachable (source, sink) pairs, compact ids
+    PathBudget budget;
+
+    ICFGSnapshot graph;
     std::set<unsigned> sources;
     std::set<unsigned> sinks;
-    std::set<std::vector<unsigned>> reachablePaths;
+    PathTrie reachablePaths;
+
+    // Compact ids of 'graph' from here on
+    std::unordered_map<unsigned, FunSummary> summaries;   // function entry (or RootContext) -> summary
+    std::unordered_map<unsigned, std::unordered_set<unsigned>> sinkContexts;   // sink -> contexts reaching it
+    PathSink *pathSink = nullptr;   // streaming receiver of paths, if any
+    unsigned numThreads = 1;
+    mutable std::atomic<size_t> nodesVisited{0};
 };
 
 #endif //ANSWERS_ICFG_H
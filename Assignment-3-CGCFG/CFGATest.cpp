@@ -0,0 +1,426 @@
+/**
+ * CFGATest.cpp
+ * Cross-check of the path search against a plain recursive enumerator on random synthetic ICFGs, run by CTest.
+ */
+
+#include "CFGA.h"
+#include "WorkStealingPool.h"
+
+#include <cstdio>
+#include <fstream>
+#include <random>
+
+namespace
+{
+
+using Path = std::vector<unsigned>;
+using PathSet = std::set<Path>;
+
+unsigned numFailures = 0;
+
+void check(bool ok, const std::string &what)
+{
+    if (ok)
+        return;
+    std::cout << "FAILED: " + what + "\n";
+    numFailures++;
+}
+
+/// A random ICFG, kept both as a snapshot and as plain adjacency lists over ICFG ids
+struct RandomICFG
+{
+    struct Edge
+    {
+        unsigned dst;
+        ICFGSnapshot::EdgeKind kind;
+        unsigned aux;
+    };
+
+    ICFGSnapshot snapshot;
+    std::map<unsigned, std::vector<Edge>> succs;
+    std::vector<unsigned> nodes;
+    std::vector<unsigned> entries, exits;
+
+    /// ICFG ids are spread out so that they differ from the compact ids of the snapshot
+    static unsigned id(unsigned n)
+    { return 3 * n + 5; }
+
+    void edge(unsigned src, unsigned dst, ICFGSnapshot::EdgeKind kind, unsigned aux = ICFGSnapshot::None)
+    {
+        succs[src].push_back({dst, kind, aux});
+        snapshot.addEdge(src, dst, kind, aux);
+    }
+
+    explicit RandomICFG(std::mt19937 &rng)
+    {
+        unsigned numFuns = 1 + rng() % 4;
+        std::vector<std::vector<unsigned>> bodies(numFuns);
+        unsigned next = 0;
+        for (unsigned f = 0; f < numFuns; f++)
+        {
+            entries.push_back(id(next++));
+            for (unsigned i = 0, n = 1 + rng() % 5; i < n; i++)
+                bodies[f].push_back(id(next++));
+            exits.push_back(id(next++));
+        }
+        std::set<unsigned> exitSet(exits.begin(), exits.end());
+        for (unsigned n = 0; n < next; n++)
+        {
+            nodes.push_back(id(n));
+            snapshot.addNode(id(n), exitSet.count(id(n)));
+        }
+
+        for (unsigned f = 0; f < numFuns; f++)
+        {
+            std::vector<unsigned> chain = {entries[f]};
+            chain.insert(chain.end(), bodies[f].begin(), bodies[f].end());
+            for (size_t i = 0; i + 1 < chain.size(); i++)
+            {
+                // A call, possibly recursive, needs a distinct return site: the next node of the chain
+                if (rng() % 3 == 0 && i + 2 < chain.size())
+                {
+                    unsigned callee = rng() % numFuns;
+                    edge(chain[i], entries[callee], ICFGSnapshot::CallEdge, chain[i + 1]);
+                    edge(exits[callee], chain[i + 1], ICFGSnapshot::RetEdge, chain[i]);
+                }
+                else
+                    edge(chain[i], chain[i + 1], ICFGSnapshot::IntraEdge);
+                // Branches and loops within the function
+                if (rng() % 3 == 0)
+                    edge(chain[i], chain[rng() % chain.size()], ICFGSnapshot::IntraEdge);
+            }
+            edge(chain.back(), exits[f], ICFGSnapshot::IntraEdge);
+        }
+        snapshot.finalize();
+    }
+};
+
+/**
+ * Enumerates the realizable paths the way the search defines them: a (node, call stack) state appears at most
+ * once on a path, a call site at most once on the stack, and returns on an empty stack are unmatched.
+ */
+class ReferenceSearch
+{
+public:
+    ReferenceSearch(const RandomICFG &graph, size_t maxLength) : graph(graph), maxLength(maxLength)
+    {}
+
+    /// False if the enumeration was cut off for taking too many steps
+    bool run(unsigned src, unsigned snk, PathSet &paths)
+    {
+        this->snk = snk;
+        out = &paths;
+        visit(src);
+        return steps <= MaxSteps;
+    }
+
+private:
+    static constexpr size_t MaxSteps = 200000;
+
+    void visit(unsigned cur)
+    {
+        if (++steps > MaxSteps || (maxLength && path.size() >= maxLength))
+            return;
+        auto state = std::make_pair(cur, stack);
+        if (!visited.insert(state).second)
+            return;
+        path.push_back(cur);
+        if (cur == snk)
+            out->insert(path);
+
+        auto succItr = graph.succs.find(cur);
+        if (succItr != graph.succs.end())
+        {
+            for (auto &edge : succItr->second)
+            {
+                if (edge.kind == ICFGSnapshot::IntraEdge)
+                    visit(edge.dst);
+                else if (edge.kind == ICFGSnapshot::CallEdge)
+                {
+                    if (std::find(stack.begin(), stack.end(), cur) != stack.end())
+                        continue;
+                    stack.push_back(cur);
+                    visit(edge.dst);
+                    stack.pop_back();
+                }
+                else if (stack.empty())
+                    visit(edge.dst);
+                else if (stack.back() == edge.aux)
+                {
+                    stack.pop_back();
+                    visit(edge.dst);
+                    stack.push_back(edge.aux);
+                }
+            }
+        }
+
+        path.pop_back();
+        visited.erase(state);
+    }
+
+    const RandomICFG &graph;
+    size_t maxLength;
+    unsigned snk = 0;
+    PathSet *out = nullptr;
+    Path path;
+    std::vector<unsigned> stack;
+    std::set<std::pair<unsigned, std::vector<unsigned>>> visited;
+    size_t steps = 0;
+};
+
+/// Collects streamed paths, keeping duplicates so that they can be detected
+class CollectingSink : public PathSink
+{
+public:
+    void consume(const std::vector<unsigned> &path) override
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        paths.push_back(path);
+    }
+
+    std::mutex lock;
+    std::vector<Path> paths;
+};
+
+/// Exposes the (source, sink) pairs the summaries proved reachable, and the generator
+class TestAnalysis : public CFGAnalysis
+{
+public:
+    TestAnalysis(const ICFGSnapshot &graph, const std::set<unsigned> &sources, const std::set<unsigned> &sinks) :
+            CFGAnalysis(graph, sources, sinks)
+    {}
+
+    using CFGAnalysis::generatePaths;
+
+    /// The reachable pairs as ICFG ids; valid after analyze()
+    std::set<std::pair<unsigned, unsigned>> getSearchPairs() const
+    {
+        std::set<std::pair<unsigned, unsigned>> pairs;
+        for (auto &pair : searchPairs)
+            pairs.emplace(graph.getId(pair.first), graph.getId(pair.second));
+        return pairs;
+    }
+};
+
+PathSet toSet(const PathTrie &trie)
+{
+    return PathSet(trie.begin(), trie.end());
+}
+
+/// Nodes of 'graph' from which a sink is reachable, ignoring call matching
+std::set<unsigned> reachingSinks(const RandomICFG &graph, const std::set<unsigned> &sinks)
+{
+    std::set<unsigned> reaching(sinks.begin(), sinks.end());
+    bool changed = true;
+    while (changed)
+    {
+        changed = false;
+        for (auto &succ : graph.succs)
+        {
+            for (auto &edge : succ.second)
+            {
+                if (reaching.count(edge.dst) && reaching.insert(succ.first).second)
+                    changed = true;
+            }
+        }
+    }
+    return reaching;
+}
+
+/// False if the graph has too many paths to cross-check
+bool testGraph(const RandomICFG &graph, const std::set<unsigned> &sources, const std::set<unsigned> &sinks,
+               const std::string &name, std::mt19937 &rng)
+{
+    PathSet expected;
+    std::set<std::pair<unsigned, unsigned>> expectedPairs;
+    for (unsigned src : sources)
+    {
+        for (unsigned snk : sinks)
+        {
+            PathSet paths;
+            ReferenceSearch ref(graph, 0);
+            if (!ref.run(src, snk, paths))
+                return false;
+            if (!paths.empty())
+                expectedPairs.emplace(src, snk);
+            expected.insert(paths.begin(), paths.end());
+        }
+    }
+
+    // Sequential and parallel searches into the trie
+    for (unsigned threads : {1u, 4u})
+    {
+        std::string where = name + ", " + std::to_string(threads) + " threads";
+        TestAnalysis analysis(graph.snapshot, sources, sinks);
+        analysis.setNumThreads(threads);
+        analysis.analyze();
+        PathSet got = toSet(analysis.getPaths());
+        check(got == expected, where + ": paths");
+        check(analysis.getNumPaths() == expected.size(), where + ": path count");
+        check(std::is_sorted(analysis.getPaths().begin(), analysis.getPaths().end()), where + ": trie order");
+        check(analysis.getSearchPairs() == expectedPairs, where + ": reachable pairs");
+
+        // Pruning keeps every node of a path and drops every node that cannot reach a sink
+        std::set<unsigned> reaching = reachingSinks(graph, sinks);
+        const ICFGSnapshot &pruned = analysis.getGraph();
+        for (unsigned node = 0; node < pruned.getNumNodes(); node++)
+            check(reaching.count(pruned.getId(node)), where + ": pruned graph keeps " +
+                                                     std::to_string(pruned.getId(node)));
+        for (auto &path : expected)
+        {
+            for (unsigned node : path)
+                check(pruned.getCompactId(node) != ICFGSnapshot::None, where + ": pruned graph drops a path node");
+        }
+    }
+
+    // Streaming from the worker threads: every path exactly once
+    {
+        CollectingSink sink;
+        TestAnalysis analysis(graph.snapshot, sources, sinks);
+        analysis.setNumThreads(4);
+        analysis.setPathSink(&sink);
+        analysis.analyze();
+        PathSet got(sink.paths.begin(), sink.paths.end());
+        check(got == expected && sink.paths.size() == expected.size(), name + ": streamed paths");
+        check(analysis.getNumPaths() == 0, name + ": streamed paths are not kept");
+    }
+
+    // A path count cap makes the search sequential and stops it early
+    size_t cap = 1 + rng() % 4;
+    {
+        TestAnalysis analysis(graph.snapshot, sources, sinks);
+        analysis.setNumThreads(4);
+        PathBudget budget;
+        budget.maxPaths = cap;
+        analysis.setPathBudget(budget);
+        analysis.analyze();
+        PathSet got = toSet(analysis.getPaths());
+        check(got.size() == std::min(cap, expected.size()), name + ": capped path count");
+        check(std::includes(expected.begin(), expected.end(), got.begin(), got.end()), name + ": capped paths");
+    }
+
+    // The generator under count and length budgets
+    {
+        TestAnalysis analysis(graph.snapshot, sources, sinks);
+        analysis.analyze();
+
+        PathBudget budget;
+        budget.maxPaths = cap;
+        auto gen = analysis.generatePaths(budget);
+        PathSet got;
+        size_t count = 0;
+        for (Path path; gen.next(path); count++)
+            got.insert(path);
+        check(count == got.size() && got.size() == std::min(cap, expected.size()), name + ": generator count");
+        check(std::includes(expected.begin(), expected.end(), got.begin(), got.end()), name + ": generator paths");
+        if (expected.size() != cap)
+            check(gen.isOverBudget() == (expected.size() > cap), name + ": generator budget flag");
+
+        size_t maxLength = 2 + rng() % 6;
+        PathBudget lengthBudget;
+        lengthBudget.maxLength = maxLength;
+        auto shortGen = analysis.generatePaths(lengthBudget);
+        PathSet shortPaths;
+        for (Path path; shortGen.next(path);)
+            shortPaths.insert(path);
+        PathSet expectedShort;
+        for (auto &path : expected)
+        {
+            if (path.size() <= maxLength)
+                expectedShort.insert(path);
+        }
+        check(shortPaths == expectedShort, name + ": generator with length " + std::to_string(maxLength));
+    }
+    return true;
+}
+
+void testTrie(std::mt19937 &rng)
+{
+    PathSet expected;
+    PathTrie trie, other;
+    for (int i = 0; i < 500; i++)
+    {
+        Path path;
+        for (unsigned j = 0, len = 1 + rng() % 6; j < len; j++)
+            path.push_back(rng() % 5);
+        expected.insert(path);
+        PathTrie &target = i % 2 ? trie : other;
+        bool inTarget = std::find(target.begin(), target.end(), path) != target.end();
+        check(target.insert(path) == !inTarget, "trie insert result");
+    }
+    check(!trie.insert(Path()), "trie rejects the empty path");
+    trie.merge(other);
+    check(toSet(trie) == expected && trie.size() == expected.size(), "trie merge");
+    check(std::is_sorted(trie.begin(), trie.end()), "trie order");
+}
+
+void testPool()
+{
+    // Every task spawns two children down to a fixed depth, from whichever worker runs it
+    WorkStealingPool pool(4);
+    std::atomic<unsigned> count{0};
+    std::function<void(unsigned, unsigned)> spawn = [&](unsigned worker, unsigned depth) {
+        count++;
+        if (depth == 0)
+            return;
+        for (int i = 0; i < 2; i++)
+            pool.submit([&spawn, depth](unsigned w) { spawn(w, depth - 1); }, worker);
+    };
+    pool.submit([&spawn](unsigned w) { spawn(w, 12); }, 0);
+    pool.run();
+    check(count == (1u << 13) - 1, "pool runs every spawned task");
+}
+
+/// Parse an endpoint file with the given contents; false if the parser rejects it
+bool parseEndpoints(const std::string &contents, std::vector<std::string> &sources, std::vector<std::string> &sinks)
+{
+    const std::string fname = "cfga_test_endpoints.txt";
+    std::ofstream(fname) << contents;
+    bool ok = FunctionIndex::readEndpointFile(fname, sources, sinks);
+    std::remove(fname.c_str());
+    return ok;
+}
+
+void testEndpointFile()
+{
+    std::vector<std::string> sources, sinks;
+    check(parseEndpoints("# taint sources\nsource main\n\n  sink exit:f.*   # any f\nsource a#b\n", sources, sinks),
+          "endpoint file with comments");
+    check(sources == std::vector<std::string>{"main", "a#b"}, "endpoint file sources");
+    check(sinks == std::vector<std::string>{"exit:f.*"}, "endpoint file sinks");
+
+    check(!parseEndpoints("source main\nsinks main\n", sources, sinks), "endpoint file rejects unknown roles");
+    check(!parseEndpoints("source\n", sources, sinks), "endpoint file rejects a missing pattern");
+    check(!parseEndpoints("sink f g\n", sources, sinks), "endpoint file rejects two patterns");
+}
+
+} // namespace
+
+
+int main()
+{
+    std::mt19937 rng(11);
+
+    testTrie(rng);
+    testPool();
+    testEndpointFile();
+
+    unsigned numChecked = 0;
+    for (int round = 0; round < 300; round++)
+    {
+        RandomICFG graph(rng);
+        // The entry of the first function plus random nodes, so that unmatched returns are exercised
+        std::set<unsigned> sources = {graph.entries[0], graph.nodes[rng() % graph.nodes.size()]};
+        std::set<unsigned> sinks = {graph.exits[0], graph.nodes[rng() % graph.nodes.size()]};
+        numChecked += testGraph(graph, sources, sinks, "graph " + std::to_string(round), rng);
+    }
+    check(numChecked >= 250, "too few graphs small enough to cross-check: " + std::to_string(numChecked));
+
+    if (numFailures)
+    {
+        std::cout << numFailures << " checks failed\n";
+        return 1;
+    }
+    std::cout << "all checks passed\n";
+    return 0;
+}
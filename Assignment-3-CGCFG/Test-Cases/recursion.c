@@ -0,0 +1,25 @@
+int fact(int n) {
+	if (n <= 1)
+		return 1;
+	return n * fact(n - 1);
+}
+
+int is_odd(int n);
+
+int is_even(int n) {
+	if (n == 0)
+		return 1;
+	return is_odd(n - 1);
+}
+
+int is_odd(int n) {
+	if (n == 0)
+		return 0;
+	return is_even(n - 1);
+}
+
+int main() {
+	int a = fact(5);
+	int b = is_even(a);
+	return b;
+}
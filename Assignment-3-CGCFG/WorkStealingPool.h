@@ -0,0 +1,134 @@
+/**
+ * WorkStealingPool.h
+ * A small thread pool where each worker owns a task deque and steals from the others when idle.
+ */
+
+#ifndef ANSWERS_WORKSTEALINGPOOL_H
+#define ANSWERS_WORKSTEALINGPOOL_H
+
+#include <atomic>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class WorkStealingPool
+{
+public:
+    /// A task receives the id of the worker running it, so it can spawn onto that worker's deque
+    using Task = std::function<void(unsigned worker)>;
+
+    explicit WorkStealingPool(unsigned numWorkers)
+    {
+        for (unsigned i = 0; i < std::max(1u, numWorkers); i++)
+            queues.emplace_back(new Queue());
+    }
+
+    unsigned getNumWorkers() const
+    { return queues.size(); }
+
+    /// Queue a task on a worker's deque; callable before run() and from running tasks
+    void submit(Task task, unsigned worker)
+    {
+        pending.fetch_add(1);
+        Queue &q = *queues[worker % queues.size()];
+        std::lock_guard<std::mutex> guard(q.lock);
+        q.tasks.push_back(std::move(task));
+    }
+
+    /**
+     * Run until every task, including the ones spawned by tasks, has finished. If a task throws, the workers
+     * stop after their current task, the queued tasks are dropped and the first exception is rethrown here.
+     */
+    void run()
+    {
+        std::vector<std::thread> threads;
+        for (unsigned w = 1; w < queues.size(); w++)
+            threads.emplace_back([this, w]() { work(w); });
+        work(0);
+        for (auto &t : threads)
+            t.join();
+
+        if (failure)
+        {
+            for (auto &q : queues)
+                q->tasks.clear();
+            pending.store(0);
+            failed.store(false);
+            std::exception_ptr e = failure;
+            failure = nullptr;
+            std::rethrow_exception(e);
+        }
+    }
+
+private:
+    struct Queue
+    {
+        std::mutex lock;
+        std::deque<Task> tasks;
+    };
+
+    void work(unsigned worker)
+    {
+        Task task;
+        while (pending.load() > 0 && !failed.load())
+        {
+            if (pop(worker, task) || steal(worker, task))
+            {
+                try
+                {
+                    task(worker);
+                }
+                catch (...)
+                {
+                    std::lock_guard<std::mutex> guard(failureLock);
+                    if (!failure)
+                        failure = std::current_exception();
+                    failed.store(true);
+                }
+                pending.fetch_sub(1);
+            }
+            else
+                std::this_thread::yield();
+        }
+    }
+
+    /// Take the newest task of our own deque (depth-first, cache-warm)
+    bool pop(unsigned worker, Task &task)
+    {
+        Queue &q = *queues[worker];
+        std::lock_guard<std::mutex> guard(q.lock);
+        if (q.tasks.empty())
+            return false;
+        task = std::move(q.tasks.back());
+        q.tasks.pop_back();
+        return true;
+    }
+
+    /// Take the oldest task of another worker (the largest remaining subtree)
+    bool steal(unsigned worker, Task &task)
+    {
+        for (unsigned i = 1; i < queues.size(); i++)
+        {
+            Queue &q = *queues[(worker + i) % queues.size()];
+            std::lock_guard<std::mutex> guard(q.lock);
+            if (q.tasks.empty())
+                continue;
+            task = std::move(q.tasks.front());
+            q.tasks.pop_front();
+            return true;
+        }
+        return false;
+    }
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::atomic<size_t> pending{0};
+    std::atomic<bool> failed{false};
+    std::mutex failureLock;
+    std::exception_ptr failure;   // the first exception thrown by a task
+};
+
+#endif //ANSWERS_WORKSTEALINGPOOL_H
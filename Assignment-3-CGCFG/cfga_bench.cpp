@@ -0,0 +1,333 @@
+/**
+ * cfga_bench.cpp
+ * Throughput benchmark of CFGAnalysis on synthetic interprocedural CFGs.
+ *
+ * Usage: cfga_bench [--scales=1,2,4] [--threads=N] [--out-dir=DIR]
+ *                   [--baseline=FILE] [--save-baseline=FILE] [--tolerance=PCT]
+ *
+ * bench-baseline.txt holds the numbers of the default scales on one thread; compare against it with
+ * --baseline=bench-baseline.txt on the same machine, and refresh it with --save-baseline when the search changes.
+ */
+
+#include "CFGA.h"
+#include "Profiler.h"
+#include <fstream>
+#include <new>
+#include <sstream>
+#include <cstring>
+
+using namespace std;
+
+
+/**
+ * Builder of synthetic ICFG snapshots
+ */
+class SyntheticICFG
+{
+public:
+    struct Fun
+    {
+        unsigned entry, exit;
+    };
+
+    unsigned node(bool isFunExit = false)
+    {
+        graph.addNode(nextId, isFunExit);
+        return nextId++;
+    }
+
+    Fun function()
+    {
+        unsigned entry = node();
+        return Fun{entry, node(true)};
+    }
+
+    void intra(unsigned from, unsigned to)
+    { graph.addEdge(from, to, ICFGSnapshot::IntraEdge); }
+
+    /// A call from 'from' to 'callee'; returns the return site
+    unsigned call(unsigned from, const Fun &callee)
+    {
+        unsigned cs = node();
+        unsigned ret = node();
+        intra(from, cs);
+        graph.addEdge(cs, callee.entry, ICFGSnapshot::CallEdge, ret);
+        graph.addEdge(callee.exit, ret, ICFGSnapshot::RetEdge, cs);
+        return ret;
+    }
+
+    /// A two-way branch that joins again; returns the join node
+    unsigned diamond(unsigned from)
+    {
+        unsigned left = node(), right = node(), join = node();
+        intra(from, left);
+        intra(from, right);
+        intra(left, join);
+        intra(right, join);
+        return join;
+    }
+
+    /**
+     * Loops nested 'depth' deep; returns the exit of the outermost loop. Each body is a branch followed by the
+     * inner loop and a latch that either continues or breaks out, so the acyclic paths double with every level.
+     */
+    unsigned nestedLoops(unsigned from, unsigned depth)
+    {
+        if (depth == 0)
+            return from;
+        unsigned head = node();
+        unsigned exit = node();
+        intra(from, head);
+        intra(head, exit);
+        unsigned latch = node();
+        intra(nestedLoops(diamond(head), depth - 1), latch);
+        intra(latch, head);
+        intra(latch, exit);
+        return exit;
+    }
+
+    ICFGSnapshot finish()
+    {
+        graph.finalize();
+        return std::move(graph);
+    }
+
+private:
+    ICFGSnapshot graph;
+    unsigned nextId = 0;
+};
+
+
+struct Shape
+{
+    std::string name;
+    std::function<unsigned(unsigned)> size;   // scale -> shape parameter
+    std::function<ICFGSnapshot(unsigned, unsigned &, unsigned &)> build;   // parameter -> graph, source, sink
+    bool boundedLength;   // limit paths to size(scale) nodes, for shapes whose path count explodes with length
+};
+
+
+static std::vector<Shape> makeShapes()
+{
+    std::vector<Shape> shapes;
+
+    // main -> f1 -> ... -> fn: one long path through n nested calls
+    shapes.push_back({"call-chain", [](unsigned s) { return 1000 * s; },
+                      [](unsigned n, unsigned &src, unsigned &snk) {
+                          SyntheticICFG g;
+                          std::vector<SyntheticICFG::Fun> funs;
+                          for (unsigned i = 0; i <= n; i++)
+                              funs.push_back(g.function());
+                          for (unsigned i = 0; i < n; i++)
+                              g.intra(g.call(funs[i].entry, funs[i + 1]), funs[i].exit);
+                          g.intra(funs[n].entry, funs[n].exit);
+                          src = funs[0].entry;
+                          snk = funs[0].exit;
+                          return g.finish();
+                      }, false});
+
+    // n diamonds in a row: 2^n paths
+    shapes.push_back({"diamonds", [](unsigned s) { return 4 + 4 * s; },
+                      [](unsigned n, unsigned &src, unsigned &snk) {
+                          SyntheticICFG g;
+                          auto main = g.function();
+                          unsigned cur = main.entry;
+                          for (unsigned i = 0; i < n; i++)
+                              cur = g.diamond(cur);
+                          g.intra(cur, main.exit);
+                          src = main.entry;
+                          snk = main.exit;
+                          return g.finish();
+                      }, false});
+
+    // loops nested n deep: about 2^n paths
+    shapes.push_back({"nested-loops", [](unsigned s) { return 2 + 2 * s; },
+                      [](unsigned n, unsigned &src, unsigned &snk) {
+                          SyntheticICFG g;
+                          auto main = g.function();
+                          g.intra(g.nestedLoops(main.entry, n), main.exit);
+                          src = main.entry;
+                          snk = main.exit;
+                          return g.finish();
+                      }, false});
+
+    // f1 -> ... -> fn -> f1: each function either returns or calls the next; paths are bounded by the length budget
+    shapes.push_back({"recursion", [](unsigned s) { return 16 * s; },
+                      [](unsigned n, unsigned &src, unsigned &snk) {
+                          SyntheticICFG g;
+                          auto main = g.function();
+                          std::vector<SyntheticICFG::Fun> funs;
+                          for (unsigned i = 0; i < n; i++)
+                              funs.push_back(g.function());
+                          g.intra(g.call(main.entry, funs[0]), main.exit);
+                          for (unsigned i = 0; i < n; i++)
+                          {
+                              unsigned branch = g.node();
+                              g.intra(funs[i].entry, branch);
+                              g.intra(branch, funs[i].exit);
+                              g.intra(g.call(branch, funs[(i + 1) % n]), funs[i].exit);
+                          }
+                          src = main.entry;
+                          snk = main.exit;
+                          return g.finish();
+                      }, true});
+
+    // one callee with a branch, called from n sites: 2^n paths through a shared summary
+    shapes.push_back({"call-sites", [](unsigned s) { return 4 + 2 * s; },
+                      [](unsigned n, unsigned &src, unsigned &snk) {
+                          SyntheticICFG g;
+                          auto main = g.function();
+                          auto callee = g.function();
+                          g.intra(g.diamond(callee.entry), callee.exit);
+                          unsigned cur = main.entry;
+                          for (unsigned i = 0; i < n; i++)
+                              cur = g.call(cur, callee);
+                          g.intra(cur, main.exit);
+                          src = main.entry;
+                          snk = main.exit;
+                          return g.finish();
+                      }, false});
+
+    return shapes;
+}
+
+
+/// The phase recorded last
+static const Profiler::Record &lastPhase()
+{
+    return Profiler::getProfiler().getRecords().back();
+}
+
+
+struct Result
+{
+    double pathsPerSec;
+    size_t visited;
+    long peakKB;
+};
+
+
+int main(int argc, char **argv)
+{
+    std::vector<unsigned> scales = {1, 2, 4};
+    unsigned threads = 1;
+    std::string outDir = ".";
+    std::string baselineFile, saveBaselineFile;
+    double tolerance = 10;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        auto value = [&](const char *flag) {
+            size_t len = strlen(flag);
+            return arg.compare(0, len, flag) == 0 ? arg.substr(len) : std::string();
+        };
+        if (!value("--scales=").empty())
+        {
+            scales.clear();
+            std::stringstream ss(value("--scales="));
+            for (std::string item; std::getline(ss, item, ',');)
+                scales.push_back(std::stoul(item));
+        }
+        else if (!value("--threads=").empty())
+            threads = std::stoul(value("--threads="));
+        else if (!value("--out-dir=").empty())
+            outDir = value("--out-dir=");
+        else if (!value("--baseline=").empty())
+            baselineFile = value("--baseline=");
+        else if (!value("--save-baseline=").empty())
+            saveBaselineFile = value("--save-baseline=");
+        else if (!value("--tolerance=").empty())
+            tolerance = std::stod(value("--tolerance="));
+        else
+        {
+            std::cout << "usage: " << argv[0] << " [--scales=1,2,4] [--threads=N] [--out-dir=DIR]"
+                      << " [--baseline=FILE] [--save-baseline=FILE] [--tolerance=PCT]\n";
+            return 1;
+        }
+    }
+
+    // Baseline lines: <shape> <scale> <paths/sec> <nodes visited> <peak KiB>
+    std::map<std::pair<std::string, unsigned>, Result> baseline;
+    if (!baselineFile.empty())
+    {
+        std::ifstream in(baselineFile);
+        std::string name;
+        unsigned scale;
+        Result r;
+        while (in >> name >> scale >> r.pathsPerSec >> r.visited >> r.peakKB)
+            baseline[{name, scale}] = r;
+    }
+
+    std::ofstream save;
+    if (!saveBaselineFile.empty())
+        save.open(saveBaselineFile);
+
+    printf("%-14s %6s %10s %12s %12s %12s %10s %10s %10s\n", "shape", "scale", "nodes", "paths", "visited",
+           "paths/sec", "analyze(s)", "dump(s)", "peak(KiB)");
+
+    bool regressed = false;
+    for (auto &shape : makeShapes())
+    {
+        for (unsigned scale : scales)
+        {
+            // A larger scale of a shape that ran out of memory would too, but the other shapes still run
+            try
+            {
+                unsigned src, snk;
+                ICFGSnapshot graph = shape.build(shape.size(scale), src, snk);
+                unsigned numNodes = graph.getNumNodes();
+
+                CFGAnalysis analyzer(std::move(graph), {src}, {snk});
+                analyzer.setNumThreads(threads);
+                if (shape.boundedLength)
+                {
+                    PathBudget budget;
+                    budget.maxLength = shape.size(scale);
+                    analyzer.setPathBudget(budget);
+                }
+
+                // Each phase gets the peak RSS over its own interval
+                ProfilePhase analyzePhase("analyze", shape.name);
+                analyzer.analyze();
+                analyzePhase.stop();
+                Profiler::Record analyzed = lastPhase();
+
+                std::string fname = outDir + "/" + shape.name + ".bench.txt";
+                ProfilePhase dumpPhase("dump", shape.name);
+                analyzer.dumpPaths(fname);
+                dumpPhase.stop();
+                Profiler::Record dumped = lastPhase();
+                std::remove(fname.c_str());
+
+                double analyzeSec = analyzed.durationUs / 1e6;
+                double dumpSec = dumped.durationUs / 1e6;
+                long peakKB = std::max(analyzed.peakRSSKB, dumped.peakRSSKB);
+                Result r{analyzer.getNumPaths() / std::max(analyzeSec, 1e-9), analyzer.getNumVisited(), peakKB};
+
+                printf("%-14s %6u %10u %12zu %12zu %12.0f %10.4f %10.4f %10ld", shape.name.c_str(), scale, numNodes,
+                       analyzer.getNumPaths(), r.visited, r.pathsPerSec, analyzeSec, dumpSec, r.peakKB);
+
+                auto base = baseline.find({shape.name, scale});
+                if (base != baseline.end())
+                {
+                    double change = 100 * (r.pathsPerSec / base->second.pathsPerSec - 1);
+                    bool slower = change < -tolerance;
+                    regressed |= slower;
+                    printf("  %+.1f%% vs baseline%s", change, slower ? "  REGRESSION" : "");
+                }
+                printf("\n");
+
+                if (save)
+                    save << shape.name << ' ' << scale << ' ' << r.pathsPerSec << ' ' << r.visited << ' ' << r.peakKB
+                         << '\n';
+            }
+            catch (const std::bad_alloc &)
+            {
+                printf("%-14s %6u  out of memory\n", shape.name.c_str(), scale);
+                break;
+            }
+        }
+    }
+    return regressed ? 1 : 0;
+}
@@ -0,0 +1,150 @@
+/**
+ * cfga_cache.cpp
+ * On-disk cache of the ICFG snapshot and function index, so unchanged inputs skip the SVF frontend.
+ */
+
+#include "CFGA.h"
+#include "Cache.h"
+#include <algorithm>
+#include <fstream>
+
+using namespace SVF;
+using namespace llvm;
+using namespace std;
+
+namespace
+{
+
+const char CacheMagic[4] = {'C', 'F', 'G', 'C'};
+const uint32_t CacheVersion = 1;
+
+} // namespace
+
+
+void ICFGSnapshot::write(std::ostream &out) const
+{
+    putVector(out, ids);
+    std::vector<unsigned> exits;
+    for (unsigned node = 0; node < getNumNodes(); node++)
+    {
+        if (funExit[node])
+            exits.push_back(node);
+    }
+    putVector(out, exits);
+    putVector(out, offsets);
+    std::vector<unsigned> flat;
+    flat.reserve(edges.size() * 3);
+    for (auto &e : edges)
+    {
+        flat.push_back(e.dst);
+        flat.push_back(e.aux);
+        flat.push_back(e.kind);
+    }
+    putVector(out, flat);
+}
+
+
+bool ICFGSnapshot::read(std::istream &in)
+{
+    std::vector<unsigned> exits, flat;
+    if (!getVector(in, ids) || !getVector(in, exits) || !getVector(in, offsets) || !getVector(in, flat))
+        return false;
+    // A stale or corrupt entry must not index out of bounds: check the CSR layout and every edge end
+    if (flat.size() % 3 != 0 || offsets.size() != ids.size() + 1 || offsets.front() != 0 ||
+        offsets.back() != flat.size() / 3 || !std::is_sorted(offsets.begin(), offsets.end()))
+        return false;
+    for (size_t i = 0; i < flat.size(); i += 3)
+    {
+        unsigned dst = flat[i], aux = flat[i + 1], kind = flat[i + 2];
+        if (dst >= ids.size() || (aux != None && aux >= ids.size()) || kind > RetEdge)
+            return false;
+    }
+
+    compactIds.clear();
+    for (unsigned node = 0; node < ids.size(); node++)
+        compactIds.emplace(ids[node], node);
+    funExit.assign(ids.size(), false);
+    for (unsigned node : exits)
+    {
+        if (node >= ids.size())
+            return false;
+        funExit[node] = true;
+    }
+    edges.resize(flat.size() / 3);
+    for (size_t i = 0; i < edges.size(); i++)
+        edges[i] = Edge{flat[3 * i], flat[3 * i + 1], static_cast<EdgeKind>(flat[3 * i + 2])};
+    pending.clear();
+    return true;
+}
+
+
+void FunctionIndex::write(std::ostream &out) const
+{
+    putU32(out, functions.size());
+    for (auto &fun : functions)
+    {
+        putString(out, fun.name);
+        putU32(out, fun.entry);
+        putU32(out, fun.exit);
+        putVector(out, fun.callSites);
+    }
+}
+
+
+bool FunctionIndex::read(std::istream &in)
+{
+    uint32_t numFunctions = 0;
+    if (!getU32(in, numFunctions))
+        return false;
+    functions.clear();
+    byName.clear();
+    for (uint32_t i = 0; i < numFunctions; i++)
+    {
+        Function fun;
+        if (!getString(in, fun.name) || !getU32(in, fun.entry) || !getU32(in, fun.exit) ||
+            !getVector(in, fun.callSites))
+            return false;
+        byName.emplace(fun.name, functions.size());
+        functions.push_back(std::move(fun));
+    }
+    return true;
+}
+
+
+ICFGCache::ICFGCache(const std::string &dir, const std::vector<std::string> &inputs,
+                     const std::vector<std::string> &options)
+{
+    if (!dir.empty())
+        path = cachePath(dir, "cfga", inputs, options);
+}
+
+
+bool ICFGCache::load(std::string &moduleName, ICFGSnapshot &snapshot, FunctionIndex &index) const
+{
+    if (!isEnabled())
+        return false;
+    std::ifstream in(path, std::ios::in | std::ios::binary);
+    if (!in)
+        return false;
+
+    char magic[sizeof(CacheMagic)];
+    uint32_t version = 0;
+    return in.read(magic, sizeof(magic)) && std::equal(magic, magic + sizeof(magic), CacheMagic) &&
+           getU32(in, version) && version == CacheVersion && getString(in, moduleName) && snapshot.read(in) &&
+           index.read(in);
+}
+
+
+void ICFGCache::store(const std::string &moduleName, const ICFGSnapshot &snapshot, const FunctionIndex &index) const
+{
+    if (!isEnabled())
+        return;
+
+    writeAtomically(path, [&](std::ostream &out) {
+        out.write(CacheMagic, sizeof(CacheMagic));
+        putU32(out, CacheVersion);
+        putString(out, moduleName);
+        snapshot.write(out);
+        index.write(out);
+    });
+}
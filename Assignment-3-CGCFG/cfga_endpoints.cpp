@@ -0,0 +1,145 @@
+/**
+ * cfga_endpoints.cpp
+ * Resolution of source/sink patterns through a function name index.
+ */
+
+#include "CFGA.h"
+#include <cctype>
+#include <fstream>
+#include <sstream>
+
+using namespace SVF;
+using namespace llvm;
+using namespace std;
+
+
+FunctionIndex::FunctionIndex(SVF::CallGraph *callGraph, SVF::ICFG *icfg)
+{
+    for (auto &it : *callGraph)
+    {
+        const CallGraphNode *node = it.second;
+        const auto *fun = node->getFunction();
+
+        Function entry;
+        entry.name = fun->getName();
+        entry.entry = ICFGSnapshot::None;
+        entry.exit = ICFGSnapshot::None;
+        if (!fun->isDeclaration())
+        {
+            entry.entry = icfg->getFunEntryICFGNode(fun)->getId();
+            entry.exit = icfg->getFunExitICFGNode(fun)->getId();
+        }
+        for (const CallGraphEdge *edge : node->getInEdges())
+        {
+            for (const CallICFGNode *cs : edge->getDirectCalls())
+                entry.callSites.push_back(cs->getId());
+            for (const CallICFGNode *cs : edge->getIndirectCalls())
+                entry.callSites.push_back(cs->getId());
+        }
+
+        byName.emplace(entry.name, functions.size());
+        functions.push_back(std::move(entry));
+    }
+}
+
+
+void FunctionIndex::addEndpoints(const Function &fun, EndpointKind kind, std::set<unsigned> &out)
+{
+    if (kind == Entry && fun.entry != ICFGSnapshot::None)
+        out.insert(fun.entry);
+    else if (kind == Exit && fun.exit != ICFGSnapshot::None)
+        out.insert(fun.exit);
+    else if (kind == CallSite)
+        out.insert(fun.callSites.begin(), fun.callSites.end());
+}
+
+
+bool FunctionIndex::resolve(const std::string &pattern, EndpointKind defaultKind, std::set<unsigned> &out) const
+{
+    EndpointKind kind = defaultKind;
+    std::string name = pattern;
+    size_t colon = pattern.find(':');
+    if (colon != std::string::npos)
+    {
+        std::string prefix = pattern.substr(0, colon);
+        if (prefix == "entry")
+            kind = Entry;
+        else if (prefix == "exit")
+            kind = Exit;
+        else if (prefix == "call")
+            kind = CallSite;
+        else
+            return false;
+        name = pattern.substr(colon + 1);
+    }
+    if (name.empty())
+        return false;
+
+    // Plain names are a hash lookup; only real regexes scan the function list
+    if (name.find_first_of(".*+?[](){}|^$\\") == std::string::npos)
+    {
+        auto it = byName.find(name);
+        if (it != byName.end())
+            addEndpoints(functions[it->second], kind, out);
+        return true;
+    }
+
+    try
+    {
+        std::regex re(name);
+        for (auto &fun : functions)
+        {
+            if (std::regex_match(fun.name, re))
+                addEndpoints(fun, kind, out);
+        }
+    }
+    catch (const std::regex_error &)
+    {
+        return false;
+    }
+    return true;
+}
+
+
+bool FunctionIndex::readEndpointFile(const std::string &fname, std::vector<std::string> &sourcePatterns,
+                                     std::vector<std::string> &sinkPatterns)
+{
+    std::ifstream in(fname);
+    if (!in)
+    {
+        std::cout << "error opening " + fname + "!!\n";
+        return false;
+    }
+
+    unsigned lineNo = 0;
+    for (std::string line; std::getline(in, line);)
+    {
+        lineNo++;
+        for (size_t hash = line.find('#'); hash != std::string::npos; hash = line.find('#', hash + 1))
+        {
+            if (hash == 0 || std::isspace((unsigned char) line[hash - 1]))
+            {
+                line.erase(hash);
+                break;
+            }
+        }
+
+        std::stringstream ss(line);
+        std::string role, pattern, extra;
+        if (!(ss >> role))
+            continue;
+        std::string where = fname + ":" + std::to_string(lineNo) + ": ";
+        if (role != "source" && role != "sink")
+        {
+            std::cout << where + "unknown role " + role + " (expected source or sink)\n";
+            return false;
+        }
+        if (!(ss >> pattern) || ss >> extra)
+        {
+            std::cout << where + "expected one pattern after " + role + "\n";
+            return false;
+        }
+        (role == "source" ? sourcePatterns : sinkPatterns).push_back(pattern);
+    }
+    return true;
+}
@@ -11,49 +11,63 @@ using namespace llvm;
 using namespace std;
 
 
-CFGAnalysis::CFGAnalysis(SVF::ICFG *icfg)
+CFGAnalysis::CFGAnalysis(SVF::ICFG *icfg) : CFGAnalysis(icfg, {"main"}, {"main"})
 {
-    for (auto &it : *icfg)
-    {
-        auto node = it.second;
-        if (auto fEntry = dyn_cast<FunEntryICFGNode>(node))
-        {
-            if (fEntry->getFun()->getName() == "main")
-                sources.insert(it.first);
-        }
-        if (auto fExit = dyn_cast<FunExitICFGNode>(node))
+}
+
+
+CFGAnalysis::CFGAnalysis(SVF::ICFG *icfg, const std::vector<std::string> &sourcePatterns,
+                         const std::vector<std::string> &sinkPatterns) :
+        // One pass over the call graph instead of a scan of every ICFG node per endpoint
+        CFGAnalysis(ICFGSnapshot(), FunctionIndex(PAG::getPAG()->getCallGraph(), icfg), sourcePatterns, sinkPatterns)
+{
+}
+
+
+CFGAnalysis::CFGAnalysis(ICFGSnapshot snapshot, const FunctionIndex &index,
+                         const std::vector<std::string> &sourcePatterns, const std::vector<std::string> &sinkPatterns) :
+        graph(std::move(snapshot))
+{
+    auto resolveAll = [&](const std::vector<std::string> &patterns, FunctionIndex::EndpointKind kind,
+                          const std::string &role, std::set<unsigned> &out) {
+        for (auto &pattern : patterns)
         {
-            if (fExit->getFun()->getName() == "main")
-                sinks.insert(it.first);
+            std::set<unsigned> found;
+            if (!index.resolve(pattern, kind, found))
+                std::cout << "invalid " + role + " pattern: " + pattern + "\n";
+            else if (found.empty())
+                std::cout << "warning: " + role + " pattern " + pattern + " matches nothing\n";
+            out.insert(found.begin(), found.end());
         }
-    }
+    };
+    resolveAll(sourcePatterns, FunctionIndex::Entry, "source", sources);
+    resolveAll(sinkPatterns, FunctionIndex::Exit, "sink", sinks);
 }
 
 
-void CFGAnalysis::recordPath(const std::vector<unsigned int>& path)
+CFGAnalysis::CFGAnalysis(ICFGSnapshot snapshot, std::set<unsigned> sources, std::set<unsigned> sinks) :
+        graph(std::move(snapshot)), sources(std::move(sources)), sinks(std::move(sinks))
 {
-    if (path.empty())
-        return;
-    reachablePaths.insert(path);
 }
 
 
 void CFGAnalysis::dumpPaths()
 {
-    std::string fname = PAG::getPAG()->getModuleIdentifier() + ".res.txt";
-    std::ofstream outFile(fname, std::ios::out);
-    if (!outFile)
+    dumpPaths(PAG::getPAG()->getModuleIdentifier() + ".res.txt");
+}
+
+
+void CFGAnalysis::dumpPaths(const std::string &fname)
+{
+    StreamPathSink outFile(fname, StreamPathSink::Text);
+    if (!outFile.isOpen())
     {
         std::cout << "error opening " + fname + "!!\n";
         return;
     }
 
     for (auto &path : reachablePaths)
-    {
-        for (auto node : path)
-            outFile << node << ", ";
-        outFile << endl;
-    }
+        outFile.consume(path);
 
     outFile.close();
 }
\ No newline at end of file
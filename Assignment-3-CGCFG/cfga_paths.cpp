@@ -0,0 +1,108 @@
+/**
+ * cfga_paths.cpp
+ * Prefix-sharing storage of the paths found by CFGAnalysis.
+ */
+
+#include "CFGA.h"
+
+
+void PathTrie::clear()
+{
+    nodes.assign(1, TrieNode{0, None, None, false});
+    numPaths = 0;
+}
+
+
+unsigned PathTrie::getChild(unsigned parent, unsigned label)
+{
+    // Find the insertion point in the sorted sibling list
+    unsigned prev = None;
+    unsigned cur = nodes[parent].firstChild;
+    while (cur != None && nodes[cur].label < label)
+    {
+        prev = cur;
+        cur = nodes[cur].nextSibling;
+    }
+    if (cur != None && nodes[cur].label == label)
+        return cur;
+
+    unsigned idx = nodes.size();
+    nodes.push_back(TrieNode{label, None, cur, false});
+    if (prev == None)
+        nodes[parent].firstChild = idx;
+    else
+        nodes[prev].nextSibling = idx;
+    return idx;
+}
+
+
+bool PathTrie::insert(const std::vector<unsigned> &path)
+{
+    if (path.empty())
+        return false;
+
+    unsigned cur = 0;
+    for (unsigned label : path)
+        cur = getChild(cur, label);
+    if (nodes[cur].terminal)
+        return false;
+    nodes[cur].terminal = true;
+    ++numPaths;
+    return true;
+}
+
+
+void PathTrie::merge(const PathTrie &other)
+{
+    for (auto &path : other)
+        insert(path);
+}
+
+
+PathTrie::const_iterator PathTrie::begin() const
+{
+    const_iterator it;
+    it.trie = this;
+    it.stack.push_back(0);
+    it.advance();
+    return it;
+}
+
+
+bool PathTrie::const_iterator::step()
+{
+    const auto &nodes = trie->nodes;
+    unsigned child = nodes[stack.back()].firstChild;
+    if (child != None)
+    {
+        stack.push_back(child);
+        path.push_back(nodes[child].label);
+        return true;
+    }
+
+    // No child: climb until some ancestor has a next sibling
+    while (stack.size() > 1)
+    {
+        unsigned sibling = nodes[stack.back()].nextSibling;
+        stack.pop_back();
+        path.pop_back();
+        if (sibling != None)
+        {
+            stack.push_back(sibling);
+            path.push_back(nodes[sibling].label);
+            return true;
+        }
+    }
+    stack.clear();
+    return false;
+}
+
+
+void PathTrie::const_iterator::advance()
+{
+    while (step())
+    {
+        if (trie->nodes[stack.back()].terminal)
+            return;
+    }
+}
@@ -0,0 +1,272 @@
+/**
+ * cfga_search.cpp
+ * Depth-first enumeration of realizable paths over the ICFG snapshot, sequential or on a work-stealing pool.
+ */
+
+#include "CFGA.h"
+#include "WorkStealingPool.h"
+
+using namespace SVF;
+using namespace llvm;
+using namespace std;
+
+
+void CFGAnalysis::prepareGraph()
+{
+    // Nodes that cannot reach any sink are dropped before searching
+    graph = graph.pruneTo(sinks);
+    summaries.clear();
+    sinkContexts.clear();
+    searchPairs.clear();
+
+    // Summaries are tabulated first; the path searches only read them, so they can run in parallel.
+    for (auto srcId : sources)
+    {
+        unsigned src = graph.getCompactId(srcId);
+        if (src == ICFGSnapshot::None)
+            continue;
+        computeSummaries(src);
+        for (auto snkId : sinks)
+        {
+            // Only enumerate paths for pairs the summaries prove reachable
+            unsigned snk = graph.getCompactId(snkId);
+            if (snk != ICFGSnapshot::None && isReachableCompact(snk))
+                searchPairs.emplace_back(src, snk);
+        }
+    }
+    for (auto &pair : searchPairs)
+    {
+        if (!sinkContexts.count(pair.second))
+            computeSinkContexts(pair.second);
+    }
+}
+
+
+void CFGAnalysis::analyzeGraph()
+{
+    prepareGraph();
+
+    PathSink *out = pathSink ? pathSink : &reachablePaths;
+    if (numThreads > 1 && budget.maxPaths == 0 && budget.maxSeconds == 0)
+    {
+        searchParallel(searchPairs);
+        return;
+    }
+
+    PathGenerator gen = generatePaths(budget);
+    std::vector<unsigned> path;
+    while (gen.next(path))
+        out->consume(path);
+    nodesVisited += gen.numVisited;
+}
+
+
+bool CFGAnalysis::takeEdge(unsigned cur, const ICFGSnapshot::Edge &edge, PathSearch &search, StackOp &op) const
+{
+    op = NoOp;
+    if (edge.kind == ICFGSnapshot::IntraEdge)
+        return true;
+
+    if (edge.kind == ICFGSnapshot::CallEdge)
+    {
+        // A callee that can neither return nor reach the sink cannot complete a path
+        auto sumItr = summaries.find(edge.dst);
+        bool exitReachable = sumItr != summaries.end() && sumItr->second.exitReachable;
+        if (!exitReachable && !sinkContexts.at(search.snk).count(edge.dst))
+            return false;
+        // A call site already on the stack closes a recursive cycle. Like a node already on the path it is not
+        // taken again, which bounds the stack by the number of call sites and makes the search finite.
+        if (search.onStack[cur])
+            return false;
+        search.onStack[cur] = true;
+        search.callStack.push_back(CallContext{cur, (unsigned) search.path.size()});
+        op = PushedCall;
+        return true;
+    }
+
+    // Return edge: unmatched returns are allowed on an empty call stack, otherwise it must match the call site
+    if (search.callStack.empty())
+        return true;
+    if (search.callStack.back().callSite != edge.aux)
+        return false;
+    search.onStack[edge.aux] = false;
+    search.popped.push_back(search.callStack.back());
+    search.callStack.pop_back();
+    op = PoppedCall;
+    return true;
+}
+
+
+void CFGAnalysis::undoEdge(const ICFGSnapshot::Edge &edge, StackOp op, PathSearch &search)
+{
+    if (op == PushedCall)
+    {
+        search.onStack[search.callStack.back().callSite] = false;
+        search.callStack.pop_back();
+    }
+    else if (op == PoppedCall)
+    {
+        search.onStack[edge.aux] = true;
+        search.callStack.push_back(search.popped.back());
+        search.popped.pop_back();
+    }
+}
+
+
+void CFGAnalysis::searchParallel(const std::vector<std::pair<unsigned, unsigned>> &pairs)
+{
+    WorkStealingPool pool(numThreads);
+    std::vector<PathTrie> buffers(pool.getNumWorkers());   // per-worker paths, merged at the end
+
+    // Near the root every node a task enters becomes a task of its own; deeper down a task searches on its own.
+    // A streaming sink is shared by all workers instead of the per-worker buffers.
+    std::function<void(unsigned, PathGenerator &)> run = [&](unsigned worker, PathGenerator &gen) {
+        gen.splitDepth = SplitDepth;
+        gen.onSplit = [&](PathGenerator &&sub) {
+            auto task = std::make_shared<PathGenerator>(std::move(sub));
+            pool.submit([&run, task](unsigned w) { run(w, *task); }, worker);
+        };
+        PathSink *out = pathSink ? pathSink : &buffers[worker];
+        std::vector<unsigned> path;
+        while (gen.next(path))
+            out->consume(path);
+        nodesVisited += gen.numVisited;
+    };
+
+    PathBudget depthOnly;
+    depthOnly.maxLength = budget.maxLength;
+    unsigned w = 0;
+    for (auto &pair : pairs)
+    {
+        std::shared_ptr<PathGenerator> task(new PathGenerator(*this, depthOnly));   // the constructor is private
+        task->pairs.assign(1, pair);
+        pool.submit([&run, task](unsigned worker) { run(worker, *task); }, w++);
+    }
+    pool.run();
+
+    for (auto &buffer : buffers)
+        reachablePaths.merge(buffer);
+}
+
+
+CFGAnalysis::PathGenerator CFGAnalysis::generatePaths(const PathBudget &budget) const
+{
+    PathGenerator gen(*this, budget);
+    gen.pairs = searchPairs;
+    return gen;
+}
+
+
+CFGAnalysis::PathGenerator::PathGenerator(const CFGAnalysis &analysis, const PathBudget &budget) :
+        analysis(&analysis), budget(budget), search(0, 0)
+{
+    auto timeout = std::chrono::duration<double>(budget.maxSeconds);
+    deadline = std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(timeout);
+}
+
+
+bool CFGAnalysis::PathGenerator::startNextPair()
+{
+    if (nextPair >= pairs.size())
+        return false;
+    auto &pair = pairs[nextPair++];
+    search = PathSearch(pair.second, analysis->graph.getNumNodes());
+    enter(pair.first, nullptr, NoOp);
+    return true;
+}
+
+
+bool CFGAnalysis::PathGenerator::enter(unsigned node, const ICFGSnapshot::Edge *via, StackOp op)
+{
+    if (budget.maxLength && search.path.size() >= budget.maxLength)
+        return false;
+    if (!search.visited.insert(search.state(node)).second)
+        return false;
+    search.path.push_back(analysis->graph.getId(node));
+    ++numVisited;
+    frames.push_back(Frame{node, analysis->graph.succBegin(node), via, op});
+    found = node == search.snk;
+    return true;
+}
+
+
+void CFGAnalysis::PathGenerator::leave()
+{
+    Frame frame = frames.back();
+    frames.pop_back();
+    search.visited.erase(search.state(frame.node));
+    search.path.pop_back();
+    if (frame.via)
+        undoEdge(*frame.via, frame.op, search);
+}
+
+
+CFGAnalysis::PathGenerator CFGAnalysis::PathGenerator::splitTop() const
+{
+    // The copy keeps the whole path and call stack but only the top frame, so it stops once it leaves that node
+    PathGenerator sub(*analysis, budget);
+    sub.deadline = deadline;
+    sub.search = search;
+    sub.frames.assign(1, frames.back());
+    sub.found = found;
+    return sub;
+}
+
+
+bool CFGAnalysis::PathGenerator::next(std::vector<unsigned> &path)
+{
+    const ICFGSnapshot &graph = analysis->graph;
+    while (true)
+    {
+        if (found)
+        {
+            found = false;
+            path = search.path;
+            ++numPaths;
+            return true;
+        }
+        if (overBudget)
+            return false;
+        if (budget.maxPaths && numPaths >= budget.maxPaths)
+        {
+            overBudget = true;
+            return false;
+        }
+        // Reading the clock on every step would dominate the search
+        if (budget.maxSeconds > 0 && (++steps & 1023) == 0 && std::chrono::steady_clock::now() > deadline)
+        {
+            overBudget = true;
+            return false;
+        }
+
+        if (frames.empty())
+        {
+            if (!startNextPair())
+                return false;
+            continue;
+        }
+
+        Frame &top = frames.back();
+        unsigned cur = top.node;
+        if (top.next == graph.succEnd(cur))
+        {
+            leave();
+            continue;
+        }
+        const ICFGSnapshot::Edge *edge = top.next++;
+        StackOp op;
+        if (!analysis->takeEdge(cur, *edge, search, op))
+            continue;
+        if (!enter(edge->dst, edge, op))
+        {
+            undoEdge(*edge, op, search);
+            continue;
+        }
+        if (onSplit && search.path.size() <= splitDepth)
+        {
+            onSplit(splitTop());
+            found = false;
+            leave();
+        }
+    }
+}
@@ -0,0 +1,87 @@
+/**
+ * cfga_sink.cpp
+ * Streaming, buffered output of the paths found by CFGAnalysis.
+ */
+
+#include "CFGA.h"
+#include <charconv>
+
+static const char BinaryMagic[4] = {'C', 'F', 'G', 'P'};
+
+
+StreamPathSink::StreamPathSink(const std::string &fname, Format format) :
+        file(std::fopen(fname.c_str(), "wb")), format(format)
+{
+    buffer.reserve(BufferSize);
+    if (file && format == Binary)
+        buffer.insert(buffer.end(), BinaryMagic, BinaryMagic + sizeof(BinaryMagic));
+}
+
+
+void StreamPathSink::consume(const std::vector<unsigned> &path)
+{
+    if (path.empty())
+        return;
+
+    std::lock_guard<std::mutex> guard(lock);
+    if (!file)
+        return;
+
+    if (format == Text)
+    {
+        char num[16];
+        for (unsigned node : path)
+        {
+            char *end = std::to_chars(num, num + sizeof(num), node).ptr;
+            buffer.insert(buffer.end(), num, end);
+            buffer.push_back(',');
+            buffer.push_back(' ');
+        }
+        buffer.push_back('\n');
+    }
+    else
+    {
+        writeVarint(path.size());
+        writeVarint(path[0]);
+        for (size_t i = 1; i < path.size(); i++)
+        {
+            int64_t delta = (int64_t) path[i] - (int64_t) path[i - 1];
+            writeVarint(((uint64_t) delta << 1) ^ (uint64_t) (delta >> 63));
+        }
+    }
+
+    ++numPaths;
+    if (buffer.size() >= BufferSize)
+        flush();
+}
+
+
+void StreamPathSink::writeVarint(uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        buffer.push_back((char) (value | 0x80));
+        value >>= 7;
+    }
+    buffer.push_back((char) value);
+}
+
+
+void StreamPathSink::flush()
+{
+    if (file && !buffer.empty())
+        std::fwrite(buffer.data(), 1, buffer.size(), file);
+    buffer.clear();
+}
+
+
+void StreamPathSink::close()
+{
+    std::lock_guard<std::mutex> guard(lock);
+    if (!file)
+        return;
+    flush();
+    std::fclose(file);
+    file = nullptr;
+}
+
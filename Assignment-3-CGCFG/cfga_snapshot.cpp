@@ -0,0 +1,154 @@
+/**
+ * cfga_snapshot.cpp
+ * Dense CSR copy of the ICFG used by the path search.
+ */
+
+#include "CFGA.h"
+#include <algorithm>
+#include <tuple>
+
+using namespace SVF;
+using namespace llvm;
+using namespace std;
+
+
+ICFGSnapshot::ICFGSnapshot(SVF::ICFG *icfg)
+{
+    for (auto &it : *icfg)
+        addNode(it.first, SVFUtil::isa<FunExitICFGNode>(it.second));
+
+    for (auto &it : *icfg)
+    {
+        for (const ICFGEdge *edge : it.second->getOutEdges())
+        {
+            if (edge->isCallCFGEdge())
+            {
+                auto callSite = SVFUtil::cast<CallCFGEdge>(edge)->getCallSite();
+                addEdge(edge->getSrcID(), edge->getDstID(), CallEdge, callSite->getRetICFGNode()->getId());
+            }
+            else if (edge->isRetCFGEdge())
+            {
+                auto callSite = SVFUtil::cast<RetCFGEdge>(edge)->getCallSite();
+                addEdge(edge->getSrcID(), edge->getDstID(), RetEdge, callSite->getId());
+            }
+            else
+                addEdge(edge->getSrcID(), edge->getDstID(), IntraEdge);
+        }
+    }
+    finalize();
+}
+
+
+void ICFGSnapshot::addNode(unsigned id, bool isFunExit)
+{
+    if (compactIds.emplace(id, ids.size()).second)
+    {
+        ids.push_back(id);
+        funExit.push_back(isFunExit);
+    }
+}
+
+
+void ICFGSnapshot::addEdge(unsigned src, unsigned dst, EdgeKind kind, unsigned aux)
+{
+    pending.push_back(PendingEdge{src, dst, aux, kind});
+}
+
+
+void ICFGSnapshot::finalize()
+{
+    // Keep the edges of an earlier finalize() and lay everything out again
+    for (unsigned node = 0; node + 1 < offsets.size(); node++)
+    {
+        for (const Edge *e = succBegin(node); e != succEnd(node); ++e)
+            pending.push_back(PendingEdge{ids[node], ids[e->dst], e->aux == None ? None : ids[e->aux], e->kind});
+    }
+
+    offsets.assign(ids.size() + 1, 0);
+    std::vector<PendingEdge> valid;
+    valid.reserve(pending.size());
+    for (auto &e : pending)
+    {
+        unsigned src = getCompactId(e.src);
+        unsigned dst = getCompactId(e.dst);
+        if (src == None || dst == None)
+            continue;
+        unsigned aux = e.aux == None ? None : getCompactId(e.aux);
+        valid.push_back(PendingEdge{src, dst, aux, e.kind});
+    }
+    pending.clear();
+    pending.shrink_to_fit();
+
+    // Parallel duplicates would make the search report the same path twice
+    auto key = [](const PendingEdge &e) { return std::make_tuple(e.src, e.dst, e.kind, e.aux); };
+    std::sort(valid.begin(), valid.end(), [&](const PendingEdge &a, const PendingEdge &b) { return key(a) < key(b); });
+    valid.erase(std::unique(valid.begin(), valid.end(),
+                            [&](const PendingEdge &a, const PendingEdge &b) { return key(a) == key(b); }),
+                valid.end());
+    for (auto &e : valid)
+        offsets[e.src + 1]++;
+
+    for (size_t i = 1; i < offsets.size(); i++)
+        offsets[i] += offsets[i - 1];
+
+    edges.resize(valid.size());
+    std::vector<unsigned> fill(offsets.begin(), offsets.end() - 1);
+    for (auto &e : valid)
+        edges[fill[e.src]++] = Edge{e.dst, e.aux, e.kind};
+}
+
+
+ICFGSnapshot ICFGSnapshot::pruneTo(const std::set<unsigned> &targets) const
+{
+    // Backward reachability from the targets, ignoring call/return matching
+    std::vector<std::vector<unsigned>> preds(getNumNodes());
+    for (unsigned node = 0; node < getNumNodes(); node++)
+    {
+        for (const Edge *e = succBegin(node); e != succEnd(node); ++e)
+            preds[e->dst].push_back(node);
+    }
+
+    std::vector<bool> keep(getNumNodes(), false);
+    std::vector<unsigned> workList;
+    for (unsigned id : targets)
+    {
+        unsigned node = getCompactId(id);
+        if (node != None && !keep[node])
+        {
+            keep[node] = true;
+            workList.push_back(node);
+        }
+    }
+    while (!workList.empty())
+    {
+        unsigned node = workList.back();
+        workList.pop_back();
+        for (unsigned pred : preds[node])
+        {
+            if (!keep[pred])
+            {
+                keep[pred] = true;
+                workList.push_back(pred);
+            }
+        }
+    }
+
+    ICFGSnapshot pruned;
+    for (unsigned node = 0; node < getNumNodes(); node++)
+    {
+        if (keep[node])
+            pruned.addNode(ids[node], funExit[node]);
+    }
+    for (unsigned node = 0; node < getNumNodes(); node++)
+    {
+        if (!keep[node])
+            continue;
+        for (const Edge *e = succBegin(node); e != succEnd(node); ++e)
+        {
+            if (keep[e->dst])
+                pruned.addEdge(ids[node], ids[e->dst], e->kind, e->aux == None ? None : ids[e->aux]);
+        }
+    }
+    pruned.finalize();
+    return pruned;
+}
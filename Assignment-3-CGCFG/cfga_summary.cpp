@@ -0,0 +1,131 @@
+/**
+ * cfga_summary.cpp
+ * Tabulation of function summaries for context-sensitive reachability on the ICFG snapshot.
+ */
+
+#include "CFGA.h"
+
+using namespace SVF;
+using namespace llvm;
+using namespace std;
+
+
+void CFGAnalysis::computeSummaries(unsigned src)
+{
+    // Function summaries do not depend on the source and are kept; only the root context is redone.
+    summaries.erase(RootContext);
+    for (auto &it : summaries)
+    {
+        auto &sites = it.second.returnSites;
+        for (auto siteItr = sites.begin(); siteItr != sites.end();)
+        {
+            if (siteItr->first == RootContext)
+                siteItr = sites.erase(siteItr);
+            else
+                ++siteItr;
+        }
+    }
+
+    std::deque<std::pair<unsigned, unsigned>> workList;   // (context, node)
+    auto propagate = [&](unsigned ctx, unsigned node) {
+        if (summaries[ctx].reach.insert(node).second)
+            workList.emplace_back(ctx, node);
+    };
+
+    propagate(RootContext, src);
+
+    while (!workList.empty())
+    {
+        auto [ctx, node] = workList.front();
+        workList.pop_front();
+
+        for (const ICFGSnapshot::Edge *edge = graph.succBegin(node); edge != graph.succEnd(node); ++edge)
+        {
+            if (edge->kind == ICFGSnapshot::IntraEdge)
+                propagate(ctx, edge->dst);
+            else if (edge->kind == ICFGSnapshot::CallEdge)
+            {
+                unsigned callee = edge->dst;
+                unsigned retSite = edge->aux;
+                summaries[ctx].callees.insert(callee);
+                propagate(callee, callee);
+                // A return site pruned from the snapshot cannot lead to a sink
+                if (retSite == ICFGSnapshot::None)
+                    continue;
+                summaries[callee].returnSites.emplace(ctx, retSite);
+                // Reuse the callee's summary instead of walking its body again
+                if (summaries[callee].exitReachable)
+                    propagate(ctx, retSite);
+            }
+            else if (ctx == RootContext)
+            {
+                // Unmatched return: the source's function returns to any of its callers
+                propagate(ctx, edge->dst);
+            }
+        }
+
+        if (ctx != RootContext && graph.isFunExit(node) && !summaries[ctx].exitReachable)
+        {
+            summaries[ctx].exitReachable = true;
+            for (auto &site : summaries[ctx].returnSites)
+                propagate(site.first, site.second);
+        }
+    }
+}
+
+
+bool CFGAnalysis::isReachableCompact(unsigned snk) const
+{
+    // Walk the contexts entered from the root; a context reaching snk makes it realizable
+    std::unordered_set<unsigned> seen = {RootContext};
+    std::vector<unsigned> stack = {RootContext};
+    while (!stack.empty())
+    {
+        unsigned ctx = stack.back();
+        stack.pop_back();
+        auto it = summaries.find(ctx);
+        if (it == summaries.end())
+            continue;
+        if (it->second.reach.count(snk))
+            return true;
+        for (unsigned callee : it->second.callees)
+        {
+            if (seen.insert(callee).second)
+                stack.push_back(callee);
+        }
+    }
+    return false;
+}
+
+
+void CFGAnalysis::computeSinkContexts(unsigned snk)
+{
+    auto &contexts = sinkContexts[snk];
+    contexts.clear();
+    for (auto &it : summaries)
+    {
+        if (it.second.reach.count(snk))
+            contexts.insert(it.first);
+    }
+
+    // A context reaches the sink if any function it calls does
+    bool changed = true;
+    while (changed)
+    {
+        changed = false;
+        for (auto &it : summaries)
+        {
+            if (contexts.count(it.first))
+                continue;
+            for (unsigned callee : it.second.callees)
+            {
+                if (contexts.count(callee))
+                {
+                    contexts.insert(it.first);
+                    changed = true;
+                    break;
+                }
+            }
+        }
+    }
+}
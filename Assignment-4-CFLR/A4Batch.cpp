@@ -0,0 +1,273 @@
+/**
+ * A4Batch.cpp
+ * Batch driver: analyze many bitcode files in one process.
+ */
+
+#include "A4Header.h"
+#include "Cache.h"
+#include "Profiler.h"
+#include "llvm/IRReader/IRReader.h"
+#include "llvm/Support/SourceMgr.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+using namespace SVF;
+
+namespace
+{
+
+using Clock = std::chrono::steady_clock;
+
+double msSince(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+/// Per-module outcome written to the batch report
+struct ModuleReport
+{
+    std::string input;
+    std::string status = "ok";
+    double frontendMs = 0;
+    double solveMs = 0;
+    double dumpMs = 0;
+    size_t numPTEdges = 0;
+    size_t ptBytes = 0;     // resident size of the finalized PT relation
+};
+
+/// The report file; rows are written as modules finish, so a batch that dies midway still records them
+class ReportWriter
+{
+public:
+    explicit ReportWriter(const std::string &fname) : out(fname, std::ios::out)
+    {
+        out << std::fixed << std::setprecision(1);
+        out << "input\tstatus\tfrontend_ms\tsolve_ms\tdump_ms\tpt_edges\tpt_bytes" << std::endl;
+    }
+
+    bool isOpen() const
+    { return static_cast<bool>(out); }
+
+    /// Append one row and flush it; thread-safe
+    void write(const ModuleReport &report)
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        out << report.input << '\t' << report.status << '\t' << report.frontendMs << '\t' << report.solveMs << '\t'
+            << report.dumpMs << '\t' << report.numPTEdges << '\t' << report.ptBytes << std::endl;
+    }
+
+    std::ofstream &stream()
+    { return out; }
+
+private:
+    std::mutex mtx;
+    std::ofstream out;
+};
+
+/**
+ * Whether LLVM can read a file, checked in a throwaway context since SVF aborts the process on a bad input.
+ * Bitcode is loaded lazily: the header and module-level records are read, function bodies are left to the
+ * SVF frontend. Textual IR has no lazy form and is parsed in full.
+ */
+bool isReadableIR(const std::string &fname)
+{
+    llvm::LLVMContext context;
+    llvm::SMDiagnostic err;
+    if (llvm::getLazyIRFileModule(fname, err, context))
+        return true;
+    std::cout << "cannot parse " + fname + ": " + err.getMessage().str() + "\n";
+    return false;
+}
+
+/// A loaded module waiting to be solved
+struct Job
+{
+    std::unique_ptr<CFLR> solver;
+    ModuleReport *report;
+};
+
+/// Bounded FIFO between the loading thread and the solver threads
+class JobQueue
+{
+public:
+    explicit JobQueue(size_t capacity) : capacity(capacity)
+    {}
+
+    void push(Job job)
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        notFull.wait(lock, [&]() { return jobs.size() < capacity; });
+        jobs.push_back(std::move(job));
+        notEmpty.notify_one();
+    }
+
+    /// Block until a job is available; false once the queue is closed and drained
+    bool pop(Job &job)
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        notEmpty.wait(lock, [&]() { return !jobs.empty() || closed; });
+        if (jobs.empty())
+            return false;
+        job = std::move(jobs.front());
+        jobs.pop_front();
+        notFull.notify_one();
+        return true;
+    }
+
+    void close()
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        closed = true;
+        notEmpty.notify_all();
+    }
+
+private:
+    std::mutex mtx;
+    std::condition_variable notEmpty;
+    std::condition_variable notFull;
+    std::deque<Job> jobs;
+    size_t capacity;
+    bool closed = false;
+};
+
+} // namespace
+
+
+void runBatch(const std::string &manifest, unsigned numThreads, const std::string &reportFile,
+              const std::string &cacheDir, const std::vector<std::string> &options, unsigned maxFields)
+{
+    std::ifstream inFile(manifest);
+    if (!inFile)
+    {
+        std::cout << "error opening " + manifest + "!!\n";
+        return;
+    }
+    std::vector<std::string> inputs;
+    for (std::string line; std::getline(inFile, line);)
+    {
+        line.erase(0, line.find_first_not_of(" \t"));
+        line.erase(line.find_last_not_of(" \t\r") + 1);
+        if (!line.empty() && line[0] != '#')
+            inputs.push_back(line);
+    }
+
+    if (numThreads == 0)
+        numThreads = std::max(1u, std::thread::hardware_concurrency());
+
+    ReportWriter reportOut(reportFile);
+    if (!reportOut.isOpen())
+    {
+        std::cout << "error opening " + reportFile + "!!\n";
+        return;
+    }
+
+    auto batchStart = Clock::now();
+    std::vector<ModuleReport> reports(inputs.size());
+
+    // At most two loaded modules per solver wait in the queue, which bounds the memory held by pending graphs
+    JobQueue queue(2 * numThreads);
+    auto worker = [&]() {
+        Job job;
+        while (queue.pop(job))
+        {
+            auto start = Clock::now();
+            ProfilePhase solvePhase("solve", job.report->input);
+            job.solver->solve();
+            solvePhase.stop();
+            job.report->solveMs = msSince(start);
+
+            start = Clock::now();
+            ProfilePhase dumpPhase("dump", job.report->input);
+            job.solver->dumpResult();
+            dumpPhase.stop();
+            job.report->dumpMs = msSince(start);
+            job.report->numPTEdges = job.solver->getNumPTEdges();
+            job.report->ptBytes = job.solver->getPTIndexBytes();
+            job.solver.reset();
+            reportOut.write(*job.report);
+        }
+    };
+    std::vector<std::thread> threads;
+    for (unsigned tid = 0; tid < numThreads; tid++)
+        threads.emplace_back(worker);
+
+    // SVF's module set, PAG and node id allocator are singletons, so the frontend runs on this thread only
+    for (size_t i = 0; i < inputs.size(); i++)
+    {
+        ModuleReport &report = reports[i];
+        report.input = inputs[i];
+        if (!std::ifstream(inputs[i]))
+        {
+            report.status = "unreadable";
+            reportOut.write(report);
+            continue;
+        }
+
+        auto start = Clock::now();
+        std::unique_ptr<CFLR> solver(new CFLR());
+        std::string cached = cacheDir.empty() ? "" : cachePath(cacheDir, "cflr", {inputs[i]}, options);
+        if (!cached.empty() && solver->loadGraph(cached))
+            report.status = "ok (cached)";
+        else
+        {
+            // A corrupt or non-IR input would abort inside SVF and take the whole batch down
+            ProfilePhase checkPhase("check bitcode", inputs[i]);
+            bool readable = isReadableIR(inputs[i]);
+            checkPhase.stop();
+            if (!readable)
+            {
+                report.status = "unreadable";
+                report.frontendMs = msSince(start);
+                reportOut.write(report);
+                continue;
+            }
+
+            ProfilePhase loadPhase("load bitcode", inputs[i]);
+            LLVMModuleSet::buildSVFModule({inputs[i]});
+            loadPhase.stop();
+
+            ProfilePhase buildPhase("build SVFIR", inputs[i]);
+            SVFIRBuilder builder;
+            SVFIR *pag = builder.build();
+            buildPhase.stop();
+
+            ProfilePhase graphPhase("build graph", inputs[i]);
+            solver->buildGraph(pag, maxFields);
+            if (!cached.empty())
+                solver->saveGraph(cached);
+            graphPhase.stop();
+
+            // The CFLR graph is a self-contained copy, so the SVF state can go before the next module loads
+            SVFIR::releaseSVFIR();
+            LLVMModuleSet::releaseLLVMModuleSet();
+            NodeIDAllocator::unset();
+        }
+        report.frontendMs = msSince(start);
+
+        queue.push({std::move(solver), &report});
+    }
+    queue.close();
+    for (auto &t : threads)
+        t.join();
+
+    double frontendMs = 0, solveMs = 0, dumpMs = 0;
+    size_t numOk = 0;
+    for (auto &report : reports)
+    {
+        frontendMs += report.frontendMs;
+        solveMs += report.solveMs;
+        dumpMs += report.dumpMs;
+        numOk += report.status.compare(0, 2, "ok") == 0;
+    }
+    std::ofstream &out = reportOut.stream();
+    out << "# modules: " << numOk << " ok, " << reports.size() - numOk << " failed\n";
+    out << "# threads: " << numThreads << '\n';
+    out << "# total frontend_ms: " << frontendMs << ", solve_ms: " << solveMs << ", dump_ms: " << dumpMs << '\n';
+    out << "# wall_ms: " << msSince(batchStart) << '\n';
+}
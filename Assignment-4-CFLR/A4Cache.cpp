@@ -0,0 +1,100 @@
+/**
+ * A4Cache.cpp
+ * On-disk cache of the graphs built from the SVFIR, so unchanged inputs skip the SVF frontend.
+ */
+
+#include "A4Header.h"
+#include "Cache.h"
+
+#include <algorithm>
+#include <fstream>
+
+namespace
+{
+
+const char CacheMagic[4] = {'C', 'F', 'L', 'G'};
+const uint32_t CacheVersion = 3;
+
+} // namespace
+
+
+void CFLRGraph::write(std::ostream &out) const
+{
+    // Field sensitivity, then label-major runs: label, source, number of targets, targets
+    putU32(out, maxFields);
+    putU32(out, nextFieldObject);
+    uint32_t numRuns = 0;
+    for (auto &nodeItr : succMap)
+        numRuns += nodeItr.second.size();
+    putU32(out, numRuns);
+    for (auto &nodeItr : succMap)
+    {
+        for (auto &lblItr : nodeItr.second)
+        {
+            putU32(out, lblItr.first);
+            putU32(out, nodeItr.first);
+            putU32(out, lblItr.second.size());
+            for (unsigned dst : lblItr.second)
+                putU32(out, dst);
+        }
+    }
+}
+
+
+bool CFLRGraph::read(std::istream &in)
+{
+    uint32_t numRuns = 0;
+    if (!getU32(in, maxFields) || !getU32(in, nextFieldObject) || !getU32(in, numRuns))
+        return false;
+    for (uint32_t run = 0; run < numRuns; run++)
+    {
+        uint32_t label, src, numDsts;
+        if (!getU32(in, label) || !getU32(in, src) || !getU32(in, numDsts))
+            return false;
+        for (uint32_t i = 0; i < numDsts; i++)
+        {
+            uint32_t dst;
+            if (!getU32(in, dst))
+                return false;
+            addEdge(src, dst, label);
+        }
+    }
+    return true;
+}
+
+
+void CFLR::saveGraph(const std::string &fname) const
+{
+    writeAtomically(fname, [&](std::ostream &out) {
+        out.write(CacheMagic, sizeof(CacheMagic));
+        putU32(out, CacheVersion);
+        putString(out, moduleName);
+        graph->write(out);
+    });
+}
+
+
+bool CFLR::loadGraph(const std::string &fname)
+{
+    std::ifstream in(fname, std::ios::in | std::ios::binary);
+    if (!in)
+        return false;
+
+    char magic[sizeof(CacheMagic)];
+    uint32_t version = 0;
+    std::string name;
+    if (!in.read(magic, sizeof(magic)) || !std::equal(magic, magic + sizeof(magic), CacheMagic) ||
+        !getU32(in, version) || version != CacheVersion || !getString(in, name))
+        return false;
+
+    auto *loaded = new CFLRGraph();
+    if (!loaded->read(in))
+    {
+        delete loaded;
+        return false;
+    }
+    delete graph;
+    graph = loaded;
+    moduleName = name;
+    return true;
+}
@@ -6,6 +6,7 @@
 #ifndef ANSWERS_A4HEADER_H
 #define ANSWERS_A4HEADER_H
 
+#include <iterator>
 #include <utility>
 
 #include "SVF-LLVM/SVFIRBuilder.h"
@@ -25,8 +26,24 @@ enum EdgeLabelType
     VF, VFBar,
     VA, VABar,
     LV, LVBar,
+    Gep,    // field-sensitive mode only, with the field index in the label (see fieldLabel)
 };
 
+/// Labels hold an EdgeLabelType in their low bits and, for Gep, a field index above FieldShift
+constexpr unsigned FieldShift = 8;
+
+/// The field of a Gep with a variable offset: any field of the base object
+constexpr unsigned AnyField = ~0u >> FieldShift;
+
+inline EdgeLabel fieldLabel(EdgeLabelType kind, unsigned field)
+{ return kind | (field << FieldShift); }
+
+inline EdgeLabelType labelKind(EdgeLabel label)
+{ return static_cast<EdgeLabelType>(label & ((1u << FieldShift) - 1)); }
+
+inline unsigned labelField(EdgeLabel label)
+{ return label >> FieldShift; }
+
 
 /**
  * The edge type of CFL-reachability
@@ -72,8 +89,20 @@ public:
     /// We use a source -> label -> target map to represent the adjacency list of the predecessors/successors of nodes.
     using DataMap = std::unordered_map<unsigned, std::unordered_map<EdgeLabel, std::unordered_set<unsigned>>>;
 
-    /// Construct a graph from a PAG
-    explicit CFLRGraph(SVF::SVFIR *pag);
+    /**
+     * Construct a graph from a PAG
+     * @param maxFields 0 ignores field accesses; otherwise GepStmts become Gep edges (see addGep)
+     */
+    explicit CFLRGraph(SVF::SVFIR *pag, unsigned maxFields = 0);
+
+    /// Construct an empty graph, to be filled by read()
+    CFLRGraph() = default;
+
+    /// Write all edges in binary form
+    void write(std::ostream &out) const;
+
+    /// Add the edges and field settings written by write(); false if the data is truncated
+    bool read(std::istream &in);
 
     /**
      * Check whether an edge is already in the graph
@@ -92,15 +121,157 @@ public:
      */
     void addEdge(unsigned src, unsigned dst, EdgeLabel label);
 
+    /**
+     * Add a field access dst = &src->f as a Gep edge; field-sensitive graphs only.
+     * Fields from maxFields - 1 on are merged. A negative (variable) offset may reach any field of the objects
+     * src points to, including the fields before the one src points into, so it is labelled AnyField.
+     */
+    void addGep(unsigned src, unsigned dst, SVF::APOffset offset);
+
     DataMap &getSuccessorMap()
     { return succMap; }
 
     DataMap &getPredecessorMap()
     { return predMap; }
 
+    /// Free all edges; field objects keep their names
+    void clearEdges()
+    {
+        DataMap().swap(succMap);
+        DataMap().swap(predMap);
+    }
+
+    /// 0 if the graph is field-insensitive
+    unsigned getMaxFields() const
+    { return maxFields; }
+
+    /**
+     * The node standing for a field of an object, created on first use.
+     * Fields of field objects are flattened onto the base object, field 0 is the object itself,
+     * and fields from maxFields - 1 on share one node.
+     * @param created set to whether the node was created by this call
+     */
+    unsigned getFieldObject(unsigned obj, unsigned field, bool &created);
+
+    /// The object a field object belongs to, or the node itself
+    unsigned getBaseObject(unsigned node) const
+    {
+        auto fieldItr = fieldOf.find(node);
+        return fieldItr == fieldOf.end() ? node : fieldItr->second.first;
+    }
+
+    /// "base.field" for a field object, the id otherwise
+    std::string getNodeName(unsigned node) const;
+
 protected:
     DataMap predMap;   // holding predecessors
     DataMap succMap;   // holding successors
+
+    unsigned maxFields = 0;
+    unsigned nextFieldObject = 0;   // field objects are numbered above every PAG node
+    std::unordered_map<unsigned, std::pair<unsigned, unsigned>> fieldOf;   // field object -> (base object, field)
+    std::map<std::pair<unsigned, unsigned>, unsigned> fieldObjects;       // (base object, field) -> field object
+};
+
+
+/**
+ * Read-only, compressed index over the solved PT relation.
+ * The sorted targets of each node are cut into blocks of BlockSize: a block keeps its first target verbatim and
+ * the gaps to the following ones as varints. Per-node offsets give O(1) access to a row and its size, and a
+ * membership test binary-searches the block heads of the row before decoding a single block.
+ */
+class PTIndex
+{
+public:
+    static constexpr unsigned BlockSize = 64;
+
+    /// Forward iterator decoding a row
+    class const_iterator
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = unsigned;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const unsigned *;
+        using reference = unsigned;
+
+        unsigned operator*() const
+        { return value; }
+
+        const_iterator &operator++();
+
+        bool operator==(const const_iterator &rhs) const
+        { return left == rhs.left; }
+
+        bool operator!=(const const_iterator &rhs) const
+        { return left != rhs.left; }
+
+    private:
+        friend class PTIndex;
+
+        const PTIndex *index = nullptr;
+        unsigned block = 0;        // block holding the current target
+        unsigned inBlock = 0;      // position of the current target in its block
+        unsigned left = 0;         // targets left in the row, including the current one
+        unsigned value = 0;
+        const uint8_t *next = nullptr;   // varint of the next gap in the block
+    };
+
+    /// The sorted points-to set of one node
+    class Row
+    {
+    public:
+        const_iterator begin() const;
+
+        const_iterator end() const
+        { return const_iterator(); }
+
+        size_t size() const
+        { return count; }
+
+        bool empty() const
+        { return count == 0; }
+
+        /// Whether the row holds a target
+        bool contains(unsigned target) const;
+
+    private:
+        friend class PTIndex;
+
+        const PTIndex *index = nullptr;
+        unsigned firstBlock = 0;
+        unsigned count = 0;
+    };
+
+    /// Build the index from the PT edges of a solved graph
+    void build(CFLRGraph *graph);
+
+    /// Points-to set of a node (empty if the node has no PT edges)
+    Row pointsTo(unsigned node) const;
+
+    /// Whether the points-to sets of two nodes intersect
+    bool mayAlias(unsigned a, unsigned b) const;
+
+    bool isBuilt() const
+    { return !rowOffsets.empty(); }
+
+    /// Number of nodes with a row, i.e. one more than the largest node with PT edges
+    unsigned getNumRows() const
+    { return rowOffsets.empty() ? 0 : rowOffsets.size() - 1; }
+
+    /// Number of PT edges
+    size_t getNumTargets() const
+    { return rowOffsets.empty() ? 0 : rowOffsets.back(); }
+
+    /// Bytes held by the index
+    size_t memoryBytes() const;
+
+private:
+    std::vector<unsigned> rowOffsets;   // node -> number of targets of the nodes before it
+    std::vector<unsigned> rowBlocks;    // node -> its first block; rowBlocks[n + 1] ends the row
+    std::vector<unsigned> blockHeads;   // first target of each block
+    std::vector<unsigned> blockBytes;   // block -> start of its gaps in 'gaps'
+    std::vector<uint8_t> gaps;          // varint gaps between consecutive targets of a block
 };
 
 
@@ -158,20 +329,85 @@ class CFLR
 {
     WorkList<CFLREdge> workList;
     CFLRGraph *graph;
+    PTIndex ptIndex;
+    std::string moduleName;   // output files are named after it; taken from the PAG in buildGraph()
 
 public:
     CFLR() : graph(nullptr)
     {}
 
+    CFLR(const CFLR &) = delete;
+    CFLR &operator=(const CFLR &) = delete;
+
     ~CFLR()
     { delete graph; }
 
-    /// Build a graph from PAG
-    void buildGraph(SVF::PAG *pag);
+    /// Build a graph from PAG; a non-zero maxFields makes it field-sensitive (see CFLRGraph)
+    void buildGraph(SVF::PAG *pag, unsigned maxFields = 0);
     /// The dynamic-programming CFL-reachability algorithm.
     void solve();
-    /// Dump results into a file
+    /// Dump results into a file; finalizes the results first
     void dumpResult();
+
+    /**
+     * Freeze the PT relation into the compressed index used by dumpResult() and the query methods, and free the
+     * solver's edge maps; call once after solve()
+     */
+    void finalize();
+
+    bool isFinalized() const
+    { return ptIndex.isBuilt(); }
+
+    /// Number of PT edges
+    size_t getNumPTEdges() const;
+
+    /// Bytes held by the finalized PT relation
+    size_t getPTIndexBytes() const
+    { return ptIndex.memoryBytes(); }
+
+    const std::string &getModuleName() const
+    { return moduleName; }
+
+    /// Save the graph built by buildGraph() and the module name, to be reused by loadGraph()
+    void saveGraph(const std::string &fname) const;
+
+    /// Use a graph saved by saveGraph() instead of building one; false if the file is missing or invalid
+    bool loadGraph(const std::string &fname);
+
+    /// Points-to set of a node; requires finalize()
+    PTIndex::Row pointsTo(unsigned node) const
+    { return ptIndex.pointsTo(node); }
+
+    /// Whether two nodes may point to a common object; requires finalize()
+    bool mayAlias(unsigned a, unsigned b) const
+    { return ptIndex.mayAlias(a, b); }
+
+    /**
+     * Answer a file of queries, one per line: "pts <n>" or "alias <a> <b>".
+     * Queries are split across threads and the answers are written in input order.
+     * @param queryFile the file holding the queries
+     * @param outFile the file receiving one answer per query
+     * @param numThreads the number of worker threads (0 picks the hardware concurrency)
+     */
+    void answerQueries(const std::string &queryFile, const std::string &outFile, unsigned numThreads);
 };
 
+
+/**
+ * Analyze every bitcode file listed in a manifest within one process.
+ * SVF keeps its IR in process-wide singletons, so modules are loaded one at a time on the calling thread;
+ * each loaded module is copied into its own CFLRGraph, the SVF state is released, and the graph is solved
+ * and dumped on a worker thread while the next module loads. Inputs LLVM cannot parse are reported as unreadable.
+ * @param manifest the file listing one bitcode path per line ('#' starts a comment)
+ * @param numThreads the number of solver threads (0 picks the hardware concurrency)
+ * @param reportFile the file receiving per-module timings, one row per module as it finishes (so in completion
+ * order), and the batch totals at the end
+ * @param cacheDir the graph cache directory (see cachePath()), or empty for no caching
+ * @param options the options given to SVF, part of the cache key
+ * @param maxFields the field sensitivity of the graphs (see CFLRGraph)
+ */
+void runBatch(const std::string &manifest, unsigned numThreads, const std::string &reportFile,
+              const std::string &cacheDir, const std::vector<std::string> &options, unsigned maxFields);
+
+
 #endif //ANSWERS_A4HEADER_H
@@ -5,7 +5,7 @@
 
 #include "A4Header.h"
 
-CFLRGraph::CFLRGraph(SVF::SVFIR *pag)
+CFLRGraph::CFLRGraph(SVF::SVFIR *pag, unsigned maxFields) : maxFields(maxFields)
 {
     for (SVF::PAGEdge *edge : pag->getSVFStmtSet(SVF::PAGEdge::Addr))
     {
@@ -74,6 +74,25 @@ CFLRGraph::CFLRGraph(SVF::SVFIR *pag)
         addEdge(edge->getSrcID(), edge->getDstID(), Load);
         addEdge(edge->getDstID(), edge->getSrcID(), LoadBar);
     }
+
+    if (maxFields == 0)
+        return;
+
+    // Field-sensitive mode: q = &p->f becomes Gep_f(p, q); the solver turns it into Addr(o.f, q) for each o p points to
+    nextFieldObject = pag->getTotalNodeNum();
+    for (SVF::PAGEdge *edge : pag->getSVFStmtSet(SVF::PAGEdge::Gep))
+    {
+        const SVF::GepStmt *gep = SVF::SVFUtil::cast<SVF::GepStmt>(edge);
+        addGep(edge->getSrcID(), edge->getDstID(), gep->isConstantOffset() ? gep->accumulateConstantOffset() : -1);
+    }
+}
+
+
+void CFLRGraph::addGep(unsigned src, unsigned dst, SVF::APOffset offset)
+{
+    assert(maxFields > 0 && "Gep edges need a field-sensitive graph");
+    unsigned field = offset < 0 ? AnyField : std::min<SVF::APOffset>(offset, maxFields - 1);
+    addEdge(src, dst, fieldLabel(Gep, field));
 }
 
 
@@ -90,16 +109,54 @@ void CFLRGraph::addEdge(unsigned int src, unsigned int dst, EdgeLabel EdgeLabel)
 }
 
 
-void CFLR::buildGraph(SVF::PAG *pag)
+unsigned CFLRGraph::getFieldObject(unsigned obj, unsigned field, bool &created)
+{
+    created = false;
+    unsigned base = obj;
+    unsigned offset = field;
+    auto fieldItr = fieldOf.find(obj);
+    if (fieldItr != fieldOf.end())
+    {
+        base = fieldItr->second.first;
+        offset += fieldItr->second.second;
+    }
+    offset = std::min(offset, maxFields - 1);
+    if (offset == 0)
+        return base;
+
+    auto objItr = fieldObjects.emplace(std::make_pair(base, offset), nextFieldObject);
+    if (objItr.second)
+    {
+        fieldOf.emplace(nextFieldObject, std::make_pair(base, offset));
+        nextFieldObject++;
+        created = true;
+    }
+    return objItr.first->second;
+}
+
+
+std::string CFLRGraph::getNodeName(unsigned node) const
+{
+    auto fieldItr = fieldOf.find(node);
+    if (fieldItr == fieldOf.end())
+        return std::to_string(node);
+    return std::to_string(fieldItr->second.first) + "." + std::to_string(fieldItr->second.second);
+}
+
+
+void CFLR::buildGraph(SVF::PAG *pag, unsigned maxFields)
 {
     if (!graph)
-        graph = new CFLRGraph(pag);
+    {
+        graph = new CFLRGraph(pag, maxFields);
+        moduleName = pag->getModuleIdentifier();
+    }
 }
 
 
 void CFLR::dumpResult()
 {
-    std::string fname = SVF::PAG::getPAG()->getModuleIdentifier() + ".res.txt";
+    std::string fname = moduleName + ".res.txt";
     std::ofstream outFile(fname, std::ios::out);
     if (!outFile)
     {
@@ -107,25 +164,11 @@ void CFLR::dumpResult()
         return;
     }
 
-    // Collect S-edges
-    std::map<unsigned, std::set<unsigned >> edgeSet;  // ordered edge set
-    for (auto &nodeItr : graph->getSuccessorMap())
+    // Rows of the index are sorted, and so are the nodes
+    finalize();
+    for (unsigned src = 0; src < ptIndex.getNumRows(); src++)
     {
-        unsigned src = nodeItr.first;
-        for (auto &lblItr : nodeItr.second)
-        {
-            if (lblItr.first == PT)
-                for (auto dst : lblItr.second)
-                    edgeSet[src].insert(dst);
-        }
-    }
-
-    // Write S-edges
-    for (auto &srcItr : edgeSet)
-    {
-        for (auto dst : srcItr.second)
-        {
-            outFile << srcItr.first << '\t' << "points to" << '\t' << dst << std::endl;
-        }
+        for (unsigned dst : ptIndex.pointsTo(src))
+            outFile << graph->getNodeName(src) << '\t' << "points to" << '\t' << graph->getNodeName(dst) << '\n';
     }
 }
\ No newline at end of file
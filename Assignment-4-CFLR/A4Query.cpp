@@ -0,0 +1,310 @@
+/**
+ * A4Query.cpp
+ * In-process queries over the solved CFL-reachability results.
+ */
+
+#include "A4Header.h"
+
+#include <algorithm>
+#include <charconv>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+
+namespace
+{
+
+void putVarint(std::vector<uint8_t> &out, unsigned value)
+{
+    while (value >= 0x80)
+    {
+        out.push_back(static_cast<uint8_t>(value) | 0x80);
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+unsigned getVarint(const uint8_t *&in)
+{
+    unsigned value = 0;
+    for (unsigned shift = 0;; shift += 7)
+    {
+        uint8_t byte = *in++;
+        value |= static_cast<unsigned>(byte & 0x7f) << shift;
+        if (!(byte & 0x80))
+            return value;
+    }
+}
+
+/// Read a node id token; false unless the whole token is a decimal number that fits a node id
+bool getNodeId(std::istream &in, unsigned &id)
+{
+    std::string token;
+    if (!(in >> token))
+        return false;
+    // from_chars rejects a sign for unsigned types, so "-1" does not wrap around to a huge id
+    auto res = std::from_chars(token.data(), token.data() + token.size(), id);
+    return res.ec == std::errc() && res.ptr == token.data() + token.size();
+}
+
+} // namespace
+
+
+void PTIndex::build(CFLRGraph *graph)
+{
+    unsigned maxNode = 0;
+    bool any = false;
+    for (auto &nodeItr : graph->getSuccessorMap())
+    {
+        auto ptItr = nodeItr.second.find(PT);
+        if (ptItr == nodeItr.second.end() || ptItr->second.empty())
+            continue;
+        maxNode = std::max(maxNode, nodeItr.first);
+        any = true;
+    }
+
+    rowOffsets.assign(any ? maxNode + 2 : 1, 0);
+    rowBlocks.assign(rowOffsets.size(), 0);
+    blockHeads.clear();
+    blockBytes.clear();
+    gaps.clear();
+
+    std::vector<unsigned> row;
+    auto &succMap = graph->getSuccessorMap();
+    for (unsigned node = 0; node + 1 < rowOffsets.size(); node++)
+    {
+        row.clear();
+        auto nodeItr = succMap.find(node);
+        if (nodeItr != succMap.end())
+        {
+            auto ptItr = nodeItr->second.find(PT);
+            if (ptItr != nodeItr->second.end())
+                row.assign(ptItr->second.begin(), ptItr->second.end());
+        }
+        std::sort(row.begin(), row.end());
+
+        for (size_t i = 0; i < row.size(); i++)
+        {
+            if (i % BlockSize == 0)
+            {
+                blockHeads.push_back(row[i]);
+                blockBytes.push_back(gaps.size());
+            }
+            else
+                putVarint(gaps, row[i] - row[i - 1]);
+        }
+        rowOffsets[node + 1] = rowOffsets[node] + row.size();
+        rowBlocks[node + 1] = blockHeads.size();
+    }
+    blockBytes.push_back(gaps.size());
+
+    rowOffsets.shrink_to_fit();
+    rowBlocks.shrink_to_fit();
+    blockHeads.shrink_to_fit();
+    blockBytes.shrink_to_fit();
+    gaps.shrink_to_fit();
+}
+
+
+size_t PTIndex::memoryBytes() const
+{
+    return (rowOffsets.capacity() + rowBlocks.capacity() + blockHeads.capacity() + blockBytes.capacity()) *
+           sizeof(unsigned) + gaps.capacity();
+}
+
+
+PTIndex::const_iterator &PTIndex::const_iterator::operator++()
+{
+    if (--left == 0)
+        return *this;
+    if (++inBlock < BlockSize)
+        value += getVarint(next);
+    else
+    {
+        block++;
+        inBlock = 0;
+        value = index->blockHeads[block];
+        next = index->gaps.data() + index->blockBytes[block];
+    }
+    return *this;
+}
+
+
+PTIndex::const_iterator PTIndex::Row::begin() const
+{
+    const_iterator it;
+    if (count == 0)
+        return it;
+    it.index = index;
+    it.block = firstBlock;
+    it.left = count;
+    it.value = index->blockHeads[firstBlock];
+    it.next = index->gaps.data() + index->blockBytes[firstBlock];
+    return it;
+}
+
+
+bool PTIndex::Row::contains(unsigned target) const
+{
+    if (count == 0)
+        return false;
+    // The last block whose head is not above the target is the only one that can hold it
+    unsigned lastBlock = firstBlock + (count + BlockSize - 1) / BlockSize;
+    const unsigned *heads = index->blockHeads.data();
+    const unsigned *block = std::upper_bound(heads + firstBlock, heads + lastBlock, target);
+    if (block == heads + firstBlock)
+        return false;
+    --block;
+    unsigned b = block - heads;
+    unsigned value = *block;
+    if (value == target)
+        return true;
+
+    unsigned inBlock = std::min<unsigned>(BlockSize, count - (b - firstBlock) * BlockSize);
+    const uint8_t *next = index->gaps.data() + index->blockBytes[b];
+    for (unsigned i = 1; i < inBlock && value < target; i++)
+        value += getVarint(next);
+    return value == target;
+}
+
+
+PTIndex::Row PTIndex::pointsTo(unsigned node) const
+{
+    Row row;
+    if (node >= getNumRows())
+        return row;
+    row.index = this;
+    row.firstBlock = rowBlocks[node];
+    row.count = rowOffsets[node + 1] - rowOffsets[node];
+    return row;
+}
+
+
+bool PTIndex::mayAlias(unsigned a, unsigned b) const
+{
+    Row ra = pointsTo(a);
+    Row rb = pointsTo(b);
+    if (ra.empty() || rb.empty())
+        return false;
+    if (a == b)
+        return true;
+
+    // Merge-style intersection; probe the longer row block by block when the sizes are skewed
+    if (ra.size() > rb.size())
+        std::swap(ra, rb);
+    if (ra.size() * 16 < rb.size())
+    {
+        for (unsigned t : ra)
+        {
+            if (rb.contains(t))
+                return true;
+        }
+        return false;
+    }
+
+    auto i = ra.begin(), j = rb.begin();
+    while (i != ra.end() && j != rb.end())
+    {
+        if (*i == *j)
+            return true;
+        if (*i < *j)
+            ++i;
+        else
+            ++j;
+    }
+    return false;
+}
+
+
+void CFLR::finalize()
+{
+    if (ptIndex.isBuilt())
+        return;
+    ptIndex.build(graph);
+    graph->clearEdges();
+}
+
+
+size_t CFLR::getNumPTEdges() const
+{
+    if (ptIndex.isBuilt())
+        return ptIndex.getNumTargets();
+    size_t num = 0;
+    for (auto &nodeItr : graph->getSuccessorMap())
+    {
+        auto ptItr = nodeItr.second.find(PT);
+        if (ptItr != nodeItr.second.end())
+            num += ptItr->second.size();
+    }
+    return num;
+}
+
+
+void CFLR::answerQueries(const std::string &queryFile, const std::string &outFile, unsigned numThreads)
+{
+    std::ifstream inFile(queryFile);
+    if (!inFile)
+    {
+        std::cout << "error opening " + queryFile + "!!\n";
+        return;
+    }
+    std::vector<std::string> queries;
+    for (std::string line; std::getline(inFile, line);)
+    {
+        if (!line.empty() && line[0] != '#')
+            queries.push_back(line);
+    }
+
+    finalize();
+
+    if (numThreads == 0)
+        numThreads = std::max(1u, std::thread::hardware_concurrency());
+    numThreads = std::min<size_t>(numThreads, std::max<size_t>(1, queries.size()));
+
+    // Each worker answers a contiguous chunk into its own buffer; buffers are concatenated in order
+    std::vector<std::string> answers(numThreads);
+    auto worker = [&](unsigned tid) {
+        size_t chunk = (queries.size() + numThreads - 1) / numThreads;
+        size_t begin = tid * chunk;
+        size_t end = std::min(queries.size(), begin + chunk);
+        std::string &out = answers[tid];
+        for (size_t q = begin; q < end; q++)
+        {
+            std::istringstream ss(queries[q]);
+            std::string kind;
+            unsigned a = 0, b = 0;
+            ss >> kind;
+            if (kind == "pts" && getNodeId(ss, a))
+            {
+                out += "pts " + std::to_string(a) + ":";
+                for (unsigned t : pointsTo(a))
+                    out += " " + std::to_string(t);
+                out += '\n';
+            }
+            else if (kind == "alias" && getNodeId(ss, a) && getNodeId(ss, b))
+            {
+                out += "alias " + std::to_string(a) + " " + std::to_string(b) + ": ";
+                out += mayAlias(a, b) ? "true\n" : "false\n";
+            }
+            else
+                out += "invalid query: " + queries[q] + '\n';
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (unsigned tid = 1; tid < numThreads; tid++)
+        threads.emplace_back(worker, tid);
+    worker(0);
+    for (auto &t : threads)
+        t.join();
+
+    std::ofstream out(outFile, std::ios::out);
+    if (!out)
+    {
+        std::cout << "error opening " + outFile + "!!\n";
+        return;
+    }
+    for (auto &buf : answers)
+        out.write(buf.data(), buf.size());
+}
@@ -4,32 +4,105 @@
  */
 
 #include "A4Header.h"
+#include "Cache.h"
+#include "Profiler.h"
+
+#include <functional>
 
 using namespace SVF;
 using namespace llvm;
 using namespace std;
 
+static ToolOption<std::string> AliasQueries("alias-queries",
+                                            "File of alias queries (\"pts <n>\" or \"alias <a> <b>\" per line) answered after solving",
+                                            "");
+static ToolOption<u32_t> QueryThreads("query-threads", "Number of threads answering alias queries (0: all cores)", 0);
+static ToolOption<std::string> BatchManifest("batch",
+                                             "File listing one bitcode input per line; each is analyzed on its own in one process",
+                                             "");
+static ToolOption<u32_t> BatchThreads("batch-threads", "Number of solver threads in batch mode (0: all cores)", 0);
+static ToolOption<std::string> BatchReport("batch-report", "Timing report written in batch mode", "cflr.batch.txt");
+// Field sensitivity changes the graph built from the SVFIR, so it stays a plain option and part of the cache key
+static Option<u32_t> FieldLimit("cflr-fields",
+                               "Distinguish this many fields per object (0: field-insensitive; larger offsets share the last field)",
+                               0);
+static ToolOption<std::string> CacheDir("cache-dir", "Directory caching the graphs built from bitcode (empty: no cache)", "");
+
+/// The file pag->dump(<module>.dot) writes: the dumper appends another .dot extension
+static std::string pagDotFile(const std::string &moduleName)
+{
+    return moduleName + ".dot.dot";
+}
+
 int main(int argc, char **argv)
 {
+    ProfilePhase parsePhase("parse options");
     auto moduleNameVec =
             OptionBase::parseOptions(argc, argv, "Whole Program Points-to Analysis",
                                      "[options] <input-bitcode...>");
+    Profiler::getProfiler().configure();
+    parsePhase.stop();
 
-    LLVMModuleSet::buildSVFModule(moduleNameVec);
+    // An unusable cache directory disables the cache
+    std::string cacheDir = CacheDir();
+    if (!cacheDir.empty() && !createCacheDir(cacheDir))
+        cacheDir.clear();
 
-    SVFIRBuilder builder;
-    auto pag = builder.build();
-    
-    std::string pagDotFile = pag->getModuleIdentifier() + ".dot";
-    pag->dump(pagDotFile);
+    if (!BatchManifest().empty())
+    {
+        runBatch(BatchManifest(), BatchThreads(), BatchReport(), cacheDir, svfOptions(argc, argv), FieldLimit());
+        Profiler::getProfiler().finish();
+        return 0;
+    }
 
+    // A cache hit restores the graph and the PAG dump and skips LLVM parsing and SVFIR construction
+    // Without its PAG dump an entry is a miss, so a hit leaves the same files as a cold run
     CFLR solver;
-    solver.buildGraph(pag);
+    ProfilePhase cachePhase("load cached graph");
+    std::string cached = cacheDir.empty() ? "" : cachePath(cacheDir, "cflr", moduleNameVec, svfOptions(argc, argv));
+    bool fromCache = !cached.empty() && solver.loadGraph(cached) &&
+                     copyFile(cached + ".dot", pagDotFile(solver.getModuleName()));
+    cachePhase.stop();
+    if (!fromCache)
+    {
+        ProfilePhase loadPhase("load bitcode");
+        LLVMModuleSet::buildSVFModule(moduleNameVec);
+        loadPhase.stop();
+
+        ProfilePhase buildPhase("build SVFIR");
+        SVFIRBuilder builder;
+        auto pag = builder.build();
+        buildPhase.stop();
+
+        ProfilePhase pagDumpPhase("dump PAG");
+        pag->dump(pag->getModuleIdentifier() + ".dot");
+        pagDumpPhase.stop();
+
+        ProfilePhase graphPhase("build graph");
+        solver.buildGraph(pag, FieldLimit());
+        if (!cached.empty() && copyFile(pagDotFile(solver.getModuleName()), cached + ".dot"))
+            solver.saveGraph(cached);
+        graphPhase.stop();
+    }
+
+    ProfilePhase solvePhase("solve");
     // TODO: 完成此方法
     solver.solve();
+    solvePhase.stop();
+
+    ProfilePhase dumpPhase("dump");
     solver.dumpResult();
+    dumpPhase.stop();
 
-    LLVMModuleSet::releaseLLVMModuleSet();
+    if (!AliasQueries().empty())
+    {
+        ProfilePhase queryPhase("alias queries");
+        solver.answerQueries(AliasQueries(), solver.getModuleName() + ".alias.txt", QueryThreads());
+    }
+
+    if (!fromCache)
+        LLVMModuleSet::releaseLLVMModuleSet();
+    Profiler::getProfiler().finish();
     return 0;
 }
 
@@ -72,6 +145,28 @@ void CFLR::solve()
         insertNewEdge(nodeId, nodeId, VA);
     }
 
+    // 字段敏感模式：PT(p, o) 与 Gep_f(p, q) 相遇时，q 指向 o 的字段 f，即加入 Addr(o.f, q)
+    // 偏移未知（AnyField）时，q 可能指向 o 所属对象的任一字段
+    std::function<void(unsigned, unsigned, unsigned)> addFieldAddr = [&](unsigned obj, unsigned field, unsigned ptr) {
+        if (field == AnyField)
+        {
+            unsigned base = graph->getBaseObject(obj);
+            for (unsigned f = 0; f < graph->getMaxFields(); f++)
+                addFieldAddr(base, f, ptr);
+            return;
+        }
+        bool created;
+        unsigned fieldObj = graph->getFieldObject(obj, field, created);
+        if (created)
+        {
+            insertNewEdge(fieldObj, fieldObj, VF);
+            insertNewEdge(fieldObj, fieldObj, VFBar);
+            insertNewEdge(fieldObj, fieldObj, VA);
+        }
+        insertNewEdge(fieldObj, ptr, Addr);
+        insertNewEdge(ptr, fieldObj, AddrBar);
+    };
+
     // 辅助函数：应用前向规则 A -> B C（如果src->dst有标签A且dst->next有标签B，则添加src->next标签C）
     auto applyForwardRule = [&](unsigned src, unsigned dst, EdgeLabel srcLabel, EdgeLabel followLabel, EdgeLabel resultLabel) {
         auto &succMap = graph->getSuccessorMap();
@@ -104,7 +199,7 @@ void CFLR::solve()
         auto &predecessorMap = graph->getPredecessorMap();
 
         // 根据边标签使用switch语句应用语法规则
-        switch (edgeLabel)
+        switch (labelKind(edgeLabel))
         {
             case VFBar:
                 applyForwardRule(src, dst, VFBar, AddrBar, PT);
@@ -196,6 +291,28 @@ void CFLR::solve()
 
             case PT:
                 applyBackwardRule(src, dst, PT, VA, VP);
+                if (graph->getMaxFields() > 0 && successorMap.count(src))
+                {
+                    // 先收集 src 的 Gep 出边，插入新边可能使遍历中的标签表失效
+                    std::vector<std::pair<unsigned, unsigned>> geps;
+                    for (auto &lblItr : successorMap[src])
+                    {
+                        if (labelKind(lblItr.first) == Gep)
+                            for (auto ptr : lblItr.second)
+                                geps.emplace_back(labelField(lblItr.first), ptr);
+                    }
+                    for (auto &gep : geps)
+                        addFieldAddr(dst, gep.first, gep.second);
+                }
+                break;
+
+            case Gep:
+                if (successorMap.count(src) && successorMap[src].count(PT))
+                {
+                    std::vector<unsigned> objs(successorMap[src][PT].begin(), successorMap[src][PT].end());
+                    for (auto obj : objs)
+                        addFieldAddr(obj, labelField(edgeLabel), dst);
+                }
                 break;
 
             default:
@@ -0,0 +1,185 @@
+/**
+ * PTIndexTest.cpp
+ * Cross-check of the compressed PT index against plain sets, run by CTest.
+ */
+
+#include "A4Header.h"
+
+#include <climits>
+#include <map>
+#include <random>
+#include <set>
+
+namespace
+{
+
+using RefRows = std::map<unsigned, std::set<unsigned>>;
+
+unsigned numFailures = 0;
+
+void check(bool ok, const std::string &what)
+{
+    if (ok)
+        return;
+    std::cout << "FAILED: " + what + "\n";
+    numFailures++;
+}
+
+/// Compare every row, membership test and alias query of the index with the reference rows
+void compare(const PTIndex &index, const RefRows &ref, const std::string &name, std::mt19937 &rng)
+{
+    size_t total = 0;
+    unsigned lastNode = 0;
+    for (auto &row : ref)
+    {
+        total += row.second.size();
+        lastNode = std::max(lastNode, row.first);
+    }
+    check(index.getNumTargets() == total, name + ": number of targets");
+    check(index.getNumRows() == (ref.empty() ? 0 : lastNode + 1), name + ": number of rows");
+
+    // Nodes past the last row, up to the largest id, must read as empty
+    std::vector<unsigned> nodes = {lastNode + 1, lastNode + 2, UINT_MAX - 1, UINT_MAX};
+    for (unsigned node = 0; node <= lastNode; node++)
+        nodes.push_back(node);
+
+    for (unsigned node : nodes)
+    {
+        std::string where = name + ": node " + std::to_string(node);
+        auto refItr = ref.find(node);
+        std::vector<unsigned> expected;
+        if (refItr != ref.end())
+            expected.assign(refItr->second.begin(), refItr->second.end());
+
+        PTIndex::Row row = index.pointsTo(node);
+        std::vector<unsigned> got(row.begin(), row.end());
+        check(got == expected, where + ": row");
+        check(row.size() == expected.size() && row.empty() == expected.empty(), where + ": row size");
+
+        // Every target, its neighbours, the extremes and some random values
+        std::vector<unsigned> probes = {0, 1, UINT_MAX - 1, UINT_MAX};
+        for (unsigned t : expected)
+        {
+            probes.push_back(t);
+            probes.push_back(t - 1);
+            probes.push_back(t + 1);
+        }
+        for (int i = 0; i < 16; i++)
+            probes.push_back(rng() % 4096);
+        for (unsigned t : probes)
+        {
+            bool inRef = refItr != ref.end() && refItr->second.count(t);
+            check(row.contains(t) == inRef, where + ": contains " + std::to_string(t));
+        }
+
+        for (int i = 0; i < 8; i++)
+        {
+            unsigned other = nodes[rng() % nodes.size()];
+            auto otherItr = ref.find(other);
+            bool alias = false;
+            if (refItr != ref.end() && otherItr != ref.end())
+            {
+                for (unsigned t : refItr->second)
+                    alias = alias || otherItr->second.count(t);
+            }
+            check(index.mayAlias(node, other) == alias, where + ": alias with " + std::to_string(other));
+        }
+    }
+}
+
+/// Build an index from the reference rows, with a non-PT edge per row so that rows without targets exist
+void runCase(const RefRows &ref, const std::string &name, std::mt19937 &rng)
+{
+    CFLRGraph graph;
+    for (auto &row : ref)
+    {
+        graph.addEdge(row.first, row.first + 1, VF);
+        for (unsigned t : row.second)
+            graph.addEdge(row.first, t, PT);
+    }
+    PTIndex index;
+    index.build(&graph);
+
+    RefRows nonEmpty;
+    for (auto &row : ref)
+    {
+        if (!row.second.empty())
+            nonEmpty.insert(row);
+    }
+    compare(index, nonEmpty, name, rng);
+}
+
+/// 'count' distinct targets spread so that the gaps need one to five varint bytes
+std::set<unsigned> spreadTargets(unsigned count, std::mt19937 &rng)
+{
+    std::set<unsigned> targets;
+    while (targets.size() < count)
+    {
+        switch (rng() % 4)
+        {
+            case 0: targets.insert(rng() % 128); break;
+            case 1: targets.insert(rng() % 100000); break;
+            case 2: targets.insert(rng()); break;
+            default: targets.insert(UINT_MAX - rng() % 16); break;
+        }
+    }
+    return targets;
+}
+
+} // namespace
+
+
+int main()
+{
+    const unsigned B = PTIndex::BlockSize;
+    std::mt19937 rng(7);
+
+    runCase({}, "empty graph", rng);
+
+    // Row lengths around the block boundaries, each on its own node with empty rows in between
+    RefRows blocks;
+    unsigned node = 0;
+    for (unsigned len : {1u, B - 1, B, B + 1, 2 * B, 2 * B + 1, 5 * B})
+    {
+        blocks[node++];
+        blocks[node++] = spreadTargets(len, rng);
+    }
+    runCase(blocks, "block boundaries", rng);
+
+    // The last row is a whole number of blocks, so the row ends exactly at the end of the index
+    RefRows lastRow;
+    lastRow[0] = spreadTargets(3, rng);
+    lastRow[3];
+    lastRow[9] = spreadTargets(2 * B, rng);
+    runCase(lastRow, "full last row", rng);
+
+    // A single row holding both extremes of the id range
+    RefRows extremes;
+    extremes[4] = {0, 1, UINT_MAX - 1, UINT_MAX};
+    runCase(extremes, "extreme targets", rng);
+
+    // Random graphs: sparse and dense rows, shared targets so that aliases exist
+    for (int round = 0; round < 30; round++)
+    {
+        RefRows ref;
+        unsigned numNodes = 1 + rng() % 300;
+        for (unsigned n = 0; n < numNodes; n++)
+        {
+            if (rng() % 3 == 0)
+                continue;
+            unsigned len = rng() % (round % 3 == 0 ? 400 : 20);
+            auto &row = ref[n];
+            for (unsigned i = 0; i < len; i++)
+                row.insert(rng() % 5 == 0 ? rng() : rng() % 1000);
+        }
+        runCase(ref, "random graph " + std::to_string(round), rng);
+    }
+
+    if (numFailures)
+    {
+        std::cout << numFailures << " checks failed\n";
+        return 1;
+    }
+    std::cout << "all checks passed\n";
+    return 0;
+}
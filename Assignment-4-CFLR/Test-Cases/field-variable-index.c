@@ -0,0 +1,20 @@
+extern void MAYALIAS(void*, void*);
+
+struct S {
+  int *f0;
+  int *f1;
+};
+
+int main(int argc, char **argv){
+
+  struct S s;
+  struct S *p = &s;
+  int a, b;
+  p->f1 = &a;
+  p->f0 = &b;
+  int i = argc;
+  int *x = ((int **)p)[i];
+  MAYALIAS(x,&a);
+  MAYALIAS(x,&b);
+  return 0;
+}
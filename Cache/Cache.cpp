@@ -0,0 +1,214 @@
+/**
+ * Cache.cpp
+ * Building blocks of the on-disk caches of the tools.
+ */
+
+#include "Cache.h"
+#include "llvm/Config/llvm-config.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <set>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+/// Names of the ToolOptions; a function-local static, since options register during static initialization
+static std::set<std::string> &toolOptions()
+{
+    static std::set<std::string> names;
+    return names;
+}
+
+
+void registerToolOption(const std::string &name)
+{
+    toolOptions().insert(name);
+}
+
+
+/**
+ * Identity of the running build: the LLVM version and the size and modification time of the executable.
+ * Relinking a tool changes it, so entries written by an older build, whose graph builders may differ, are not read.
+ */
+static const std::string &buildId()
+{
+    static const std::string id = []() {
+        std::string id = LLVM_VERSION_STRING;
+        struct stat st;
+        if (stat("/proc/self/exe", &st) == 0)
+            id += " " + std::to_string(st.st_size) + " " + std::to_string(st.st_mtim.tv_sec) + "." +
+                  std::to_string(st.st_mtim.tv_nsec);
+        return id;
+    }();
+    return id;
+}
+
+
+void putU32(std::ostream &out, uint32_t value)
+{
+    out.write(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+
+bool getU32(std::istream &in, uint32_t &value)
+{
+    return static_cast<bool>(in.read(reinterpret_cast<char *>(&value), sizeof(value)));
+}
+
+
+void putString(std::ostream &out, const std::string &str)
+{
+    putU32(out, str.size());
+    out.write(str.data(), str.size());
+}
+
+
+bool getString(std::istream &in, std::string &str)
+{
+    uint32_t len = 0;
+    if (!getU32(in, len))
+        return false;
+    // Grow with the data actually read, so a corrupt length fails on the missing data instead of allocating it
+    str.clear();
+    char buf[4096];
+    for (uint32_t done = 0; done < len;)
+    {
+        uint32_t chunk = std::min<uint32_t>(sizeof(buf), len - done);
+        if (!in.read(buf, chunk))
+            return false;
+        str.append(buf, chunk);
+        done += chunk;
+    }
+    return true;
+}
+
+
+void putVector(std::ostream &out, const std::vector<unsigned> &vec)
+{
+    putU32(out, vec.size());
+    out.write(reinterpret_cast<const char *>(vec.data()), vec.size() * sizeof(unsigned));
+}
+
+
+bool getVector(std::istream &in, std::vector<unsigned> &vec)
+{
+    uint32_t size = 0;
+    if (!getU32(in, size))
+        return false;
+    vec.clear();
+    const uint32_t maxChunk = 1 << 16;
+    for (uint32_t done = 0; done < size;)
+    {
+        uint32_t chunk = std::min(maxChunk, size - done);
+        vec.resize(done + chunk);
+        if (!in.read(reinterpret_cast<char *>(vec.data() + done), chunk * sizeof(unsigned)))
+            return false;
+        done += chunk;
+    }
+    return true;
+}
+
+
+std::string cachePath(const std::string &dir, const std::string &tool, const std::vector<std::string> &inputs,
+                      const std::vector<std::string> &options)
+{
+    Fnv1a fnv;
+    fnv.update(tool);
+    fnv.update(buildId());
+    for (auto &option : options)
+        fnv.update(option);
+
+    std::vector<char> buf(1 << 16);
+    for (auto &input : inputs)
+    {
+        std::ifstream in(input, std::ios::in | std::ios::binary);
+        if (!in)
+            return "";
+        // The path is part of the key because it names the module and hence the output files
+        fnv.update(input);
+        while (in.read(buf.data(), buf.size()) || in.gcount() > 0)
+            fnv.update(buf.data(), in.gcount());
+        fnv.update("", 1);
+    }
+
+    char key[17];
+    std::snprintf(key, sizeof(key), "%016llx", static_cast<unsigned long long>(fnv.hash));
+    return dir + "/" + key + "." + tool;
+}
+
+
+bool createCacheDir(const std::string &dir)
+{
+    std::error_code ec;
+    std::filesystem::create_directories(dir, ec);
+    if (ec)
+    {
+        std::cout << "error creating " + dir + ": " + ec.message() + "!!\n";
+        return false;
+    }
+    return true;
+}
+
+
+bool writeAtomically(const std::string &fname, const std::function<void(std::ostream &)> &write)
+{
+    // The process id and a counter keep the temporary names of concurrent writers apart
+    static std::atomic<unsigned> nextTmp{0};
+    std::string tmpName = fname + ".tmp" + std::to_string(getpid()) + "." + std::to_string(nextTmp++);
+    {
+        std::ofstream out(tmpName, std::ios::out | std::ios::binary);
+        if (!out)
+        {
+            std::cout << "error opening " + tmpName + "!!\n";
+            return false;
+        }
+        write(out);
+        if (!out.flush())
+        {
+            out.close();
+            std::remove(tmpName.c_str());
+            return false;
+        }
+    }
+    if (std::rename(tmpName.c_str(), fname.c_str()) != 0)
+    {
+        std::remove(tmpName.c_str());
+        return false;
+    }
+    return true;
+}
+
+
+bool copyFile(const std::string &from, const std::string &to)
+{
+    std::ifstream in(from, std::ios::in | std::ios::binary);
+    if (!in)
+        return false;
+    return writeAtomically(to, [&](std::ostream &out) {
+        // Streaming an empty buffer would set failbit
+        if (in.peek() != std::ifstream::traits_type::eof())
+            out << in.rdbuf();
+    });
+}
+
+
+std::vector<std::string> svfOptions(int argc, char **argv)
+{
+    std::vector<std::string> options;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        size_t nameStart = arg.find_first_not_of('-');
+        if (arg.size() < 2 || arg[0] != '-' || nameStart == std::string::npos)
+            continue;
+        std::string name = arg.substr(nameStart, arg.find('=') - nameStart);
+        if (!toolOptions().count(name))
+            options.push_back(arg);
+    }
+    return options;
+}
@@ -0,0 +1,83 @@
+/**
+ * Cache.h
+ * Building blocks of the on-disk caches of the tools: content-hashed entry names, binary I/O and atomic writes.
+ */
+
+#ifndef ANSWERS_CACHE_H
+#define ANSWERS_CACHE_H
+
+#include "Util/CommandLine.h"
+
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+/// Record an option as a ToolOption, which leaves it out of svfOptions()
+void registerToolOption(const std::string &name);
+
+/**
+ * A command-line option of a tool that only acts after the SVF frontend, such as a search limit, an output path
+ * or a profiling switch. Changing it cannot change what the frontend builds, so it is not part of a cache key.
+ */
+template<typename T>
+class ToolOption : public SVF::Option<T>
+{
+public:
+    ToolOption(const std::string &name, const std::string &description, T init) :
+            SVF::Option<T>(name, description, init)
+    { registerToolOption(name); }
+};
+
+/// 64-bit FNV-1a
+struct Fnv1a
+{
+    uint64_t hash = 0xcbf29ce484222325ull;
+
+    void update(const char *data, size_t len)
+    {
+        for (size_t i = 0; i < len; i++)
+        {
+            hash ^= static_cast<unsigned char>(data[i]);
+            hash *= 0x100000001b3ull;
+        }
+    }
+
+    /// Hash a string with its terminator, so consecutive strings cannot run into each other
+    void update(const std::string &str)
+    { update(str.c_str(), str.size() + 1); }
+};
+
+/// Little helpers for the binary entry formats; the readers return false on truncated data
+void putU32(std::ostream &out, uint32_t value);
+bool getU32(std::istream &in, uint32_t &value);
+void putString(std::ostream &out, const std::string &str);
+bool getString(std::istream &in, std::string &str);
+void putVector(std::ostream &out, const std::vector<unsigned> &vec);
+bool getVector(std::istream &in, std::vector<unsigned> &vec);
+
+/**
+ * Path of the cache entry of a tool for some inputs: <dir>/<key>.<tool>, where the key is an FNV-1a hash of the
+ * tool name, the build of the tool, the options given to SVF and the bitcode paths and contents, so changing any
+ * of them misses the cache. Returns an empty string if an input cannot be read.
+ */
+std::string cachePath(const std::string &dir, const std::string &tool, const std::vector<std::string> &inputs,
+                      const std::vector<std::string> &options);
+
+/// Create the cache directory if needed; false, after reporting it, if that fails
+bool createCacheDir(const std::string &dir);
+
+/**
+ * Write a file through 'write' into a temporary file renamed over 'fname', so that concurrent runs never read a
+ * partial entry; false if the file could not be written
+ */
+bool writeAtomically(const std::string &fname, const std::function<void(std::ostream &)> &write);
+
+/// Copy a file through writeAtomically; false if 'from' cannot be read or 'to' cannot be written
+bool copyFile(const std::string &from, const std::string &to);
+
+/// The command-line options that may affect the SVF frontend, i.e. all but the ToolOptions; they belong in a cache key
+std::vector<std::string> svfOptions(int argc, char **argv);
+
+#endif //ANSWERS_CACHE_H
@@ -0,0 +1,322 @@
+/**
+ * Profiler.cpp
+ * Phase timing, peak memory and hardware counters shared by all the tools.
+ */
+
+#include "Profiler.h"
+
+#include "Cache.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+using namespace SVF;
+
+static ToolOption<bool> ProfileReport("profile", "Print the time and peak memory of each phase", false);
+static ToolOption<std::string> ProfileTrace("profile-trace", "Write the phases as a Chrome trace JSON file", "");
+static ToolOption<bool> ProfileCounters("profile-counters",
+                                        "Record cycles, instructions and cache misses per phase (Linux perf_event)", false);
+
+namespace
+{
+
+const char *const CounterNames[Profiler::NumCounters] = {"cycles", "instructions", "cache_misses"};
+
+/// Open a counter of the calling thread only
+int openCounter(uint64_t config)
+{
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = config;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+}
+
+/**
+ * The counters of one thread, opened by its first phase and closed when it exits. An inherited counter would
+ * only add a child thread's counts once that thread exits, so every thread reads its own counters instead.
+ */
+struct ThreadCounters
+{
+    int fds[Profiler::NumCounters];
+
+    ThreadCounters()
+    {
+        const uint64_t configs[Profiler::NumCounters] = {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+                                                         PERF_COUNT_HW_CACHE_MISSES};
+        for (int i = 0; i < Profiler::NumCounters; i++)
+            fds[i] = openCounter(configs[i]);
+    }
+
+    ~ThreadCounters()
+    {
+        for (int fd : fds)
+        {
+            if (fd >= 0)
+                close(fd);
+        }
+    }
+
+    static ThreadCounters &get()
+    {
+        thread_local ThreadCounters counters;
+        return counters;
+    }
+};
+
+/// Peak resident set size of the process since the last reset, in KiB
+uint64_t readPeakRSSKB()
+{
+    std::ifstream status("/proc/self/status");
+    for (std::string line; std::getline(status, line);)
+    {
+        if (line.compare(0, 6, "VmHWM:") == 0)
+            return std::stoull(line.substr(6));
+    }
+    return 0;
+}
+
+/// Reset the peak resident set size to the current one; false if the kernel does not allow it
+bool resetPeakRSS()
+{
+    std::ofstream clear("/proc/self/clear_refs");
+    return static_cast<bool>(clear << "5" << std::flush);
+}
+
+/// Escape a string for a JSON literal
+std::string jsonString(const std::string &str)
+{
+    std::string out = "\"";
+    for (char c : str)
+    {
+        if (c == '"' || c == '\\')
+            out += '\\';
+        if (static_cast<unsigned char>(c) < 0x20)
+            out += ' ';
+        else
+            out += c;
+    }
+    return out + "\"";
+}
+
+} // namespace
+
+
+Profiler &Profiler::getProfiler()
+{
+    static Profiler profiler;
+    return profiler;
+}
+
+
+Profiler::Profiler() : start(std::chrono::steady_clock::now())
+{}
+
+
+void Profiler::configure()
+{
+    if (!ProfileCounters() || countersEnabled)
+        return;
+
+    // Probe on this thread; the other threads open their counters when they first read them
+    for (int fd : ThreadCounters::get().fds)
+    {
+        if (fd < 0)
+        {
+            // Typically kernel.perf_event_paranoid forbids it, or there is no PMU (e.g. in a VM)
+            std::cout << "perf_event counters unavailable: " << std::strerror(errno) << "\n";
+            return;
+        }
+    }
+    countersEnabled = true;
+}
+
+
+void Profiler::readCounters(int64_t values[NumCounters]) const
+{
+    const int *fds = countersEnabled ? ThreadCounters::get().fds : nullptr;
+    for (int i = 0; i < NumCounters; i++)
+    {
+        uint64_t value = 0;
+        if (fds && fds[i] >= 0 && read(fds[i], &value, sizeof(value)) == sizeof(value))
+            values[i] = static_cast<int64_t>(value);
+        else
+            values[i] = -1;
+    }
+}
+
+
+double Profiler::now() const
+{
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+}
+
+
+uint64_t Profiler::getPeakRSSKB() const
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    return std::max(processPeakKB, readPeakRSSKB());
+}
+
+
+void Profiler::foldPeak(uint64_t peakKB)
+{
+    processPeakKB = std::max(processPeakKB, peakKB);
+    for (Record *rec : runningPhases)
+        rec->peakRSSKB = std::max(rec->peakRSSKB, peakKB);
+}
+
+
+void Profiler::beginPeak(Record &record)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    foldPeak(readPeakRSSKB());
+    if (peakResettable)
+        peakResettable = resetPeakRSS();
+    record.peakRSSKB = 0;
+    runningPhases.push_back(&record);
+}
+
+
+void Profiler::endPeak(Record &record)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    foldPeak(readPeakRSSKB());
+    runningPhases.erase(std::find(runningPhases.begin(), runningPhases.end(), &record));
+}
+
+
+unsigned Profiler::threadId()
+{
+    static std::atomic<unsigned> nextId{0};
+    thread_local unsigned id = nextId++;
+    return id;
+}
+
+
+void Profiler::addRecord(Record record)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    records.push_back(std::move(record));
+}
+
+
+void Profiler::finish()
+{
+    if (ProfileReport())
+        printReport(std::cout);
+    if (!ProfileTrace().empty())
+        writeTrace(ProfileTrace());
+}
+
+
+void Profiler::printReport(std::ostream &out) const
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    out << "\n*********Phase profile*********\n";
+    if (!peakResettable)
+        out << "(peak RSS of a phase is cumulative: /proc/self/clear_refs is not writable)\n";
+    out << std::left << std::setw(28) << "phase" << std::right << std::setw(8) << "thread" << std::setw(12)
+        << "wall ms" << std::setw(14) << "peak RSS MB";
+    if (countersEnabled)
+    {
+        for (auto name : CounterNames)
+            out << std::setw(16) << name;
+    }
+    out << "\n";
+
+    out << std::fixed << std::setprecision(1);
+    for (auto &rec : records)
+    {
+        std::string name = rec.detail.empty() ? rec.name : rec.name + " [" + rec.detail + "]";
+        out << std::left << std::setw(28) << name << std::right << std::setw(8) << rec.thread << std::setw(12)
+            << rec.durationUs / 1000 << std::setw(14) << rec.peakRSSKB / 1024.0;
+        if (countersEnabled)
+        {
+            for (auto value : rec.counters)
+                out << std::setw(16) << value;
+        }
+        out << "\n";
+    }
+    out << "total wall ms: " << now() / 1000 << ", peak RSS MB: " << std::max(processPeakKB, readPeakRSSKB()) / 1024.0
+        << "\n";
+    out << "*******************************\n";
+}
+
+
+void Profiler::writeTrace(const std::string &fname) const
+{
+    std::ofstream out(fname, std::ios::out);
+    if (!out)
+    {
+        std::cout << "error opening " + fname + "!!\n";
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mtx);
+    out << std::fixed << std::setprecision(3);
+    out << "{\"traceEvents\":[";
+    const char *sep = "\n";
+    for (auto &rec : records)
+    {
+        out << sep << "{\"name\":" << jsonString(rec.name) << ",\"cat\":\"phase\",\"ph\":\"X\",\"pid\":1,\"tid\":"
+            << rec.thread << ",\"ts\":" << rec.startUs << ",\"dur\":" << rec.durationUs
+            << ",\"args\":{\"peak_rss_kb\":" << rec.peakRSSKB;
+        if (!rec.detail.empty())
+            out << ",\"detail\":" << jsonString(rec.detail);
+        for (int i = 0; i < NumCounters; i++)
+        {
+            if (rec.counters[i] >= 0)
+                out << ",\"" << CounterNames[i] << "\":" << rec.counters[i];
+        }
+        out << "}}";
+        sep = ",\n";
+    }
+    out << "\n],\"displayTimeUnit\":\"ms\",\"otherData\":{\"wall_ms\":" << now() / 1000
+        << ",\"peak_rss_kb\":" << std::max(processPeakKB, readPeakRSSKB()) << "}}\n";
+}
+
+
+ProfilePhase::ProfilePhase(std::string name, std::string detail)
+{
+    Profiler &profiler = Profiler::getProfiler();
+    record.name = std::move(name);
+    record.detail = std::move(detail);
+    record.thread = Profiler::threadId();
+    profiler.beginPeak(record);
+    profiler.readCounters(record.counters);
+    record.startUs = profiler.now();
+}
+
+
+void ProfilePhase::stop()
+{
+    if (!running)
+        return;
+    running = false;
+
+    Profiler &profiler = Profiler::getProfiler();
+    record.durationUs = profiler.now() - record.startUs;
+    // Counters are per thread, so a phase ended on another thread than it started on has no deltas
+    int64_t counters[Profiler::NumCounters];
+    profiler.readCounters(counters);
+    bool sameThread = Profiler::threadId() == record.thread;
+    for (int i = 0; i < Profiler::NumCounters; i++)
+    {
+        bool valid = sameThread && counters[i] >= 0 && record.counters[i] >= 0;
+        record.counters[i] = valid ? counters[i] - record.counters[i] : -1;
+    }
+    profiler.endPeak(record);
+    profiler.addRecord(std::move(record));
+}
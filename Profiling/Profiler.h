@@ -0,0 +1,124 @@
+/**
+ * Profiler.h
+ * Phase timing, peak memory and hardware counters shared by all the tools.
+ */
+
+#ifndef ANSWERS_PROFILER_H
+#define ANSWERS_PROFILER_H
+
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * Process-wide record of the phases a tool runs through.
+ *
+ * Phases are always timed, which costs a clock read and a few /proc reads per phase. The options
+ * -profile (print a report), -profile-trace=<file> (write a Chrome trace, viewable in chrome://tracing or
+ * Perfetto) and -profile-counters (add Linux perf_event counters) decide what is reported by finish().
+ */
+class Profiler
+{
+public:
+    /// Hardware counters sampled at phase boundaries
+    enum Counter
+    {
+        Cycles, Instructions, CacheMisses, NumCounters
+    };
+
+    /// A finished phase
+    struct Record
+    {
+        std::string name;
+        std::string detail;       // e.g. the module a phase of a batch run belongs to
+        unsigned thread;          // small per-thread id, 0 for the first thread that records a phase
+        double startUs;           // since the profiler was created
+        double durationUs;
+        uint64_t peakRSSKB;       // peak RSS of the whole process while the phase ran
+        int64_t counters[NumCounters];   // deltas over the phase of the phase's own thread, -1 if not recorded
+    };
+
+    static Profiler &getProfiler();
+
+    /// Apply the profiling options; call right after the options are parsed
+    void configure();
+
+    /// Print the report and write the trace file, as requested by the options
+    void finish();
+
+    /// Add a finished phase; thread-safe
+    void addRecord(Record record);
+
+    /// Read the calling thread's counters, or fill them with -1 if they are not enabled
+    void readCounters(int64_t values[NumCounters]) const;
+
+    /// Microseconds since the profiler was created
+    double now() const;
+
+    /// Peak resident set size of the process so far, in KiB
+    uint64_t getPeakRSSKB() const;
+
+    /// Small id of the calling thread
+    static unsigned threadId();
+
+    const std::vector<Record> &getRecords() const
+    { return records; }
+
+    /// Print one line per phase and the totals
+    void printReport(std::ostream &out) const;
+
+    /// Write the phases as Chrome trace events; the totals go to "otherData"
+    void writeTrace(const std::string &fname) const;
+
+private:
+    friend class ProfilePhase;
+
+    Profiler();
+
+    /**
+     * The kernel keeps a single peak RSS per process. A phase resets it when it starts, after folding the peak
+     * reached so far into the phases still running and into the process total, so nested and concurrent phases
+     * each get the peak over their own interval.
+     */
+    void beginPeak(Record &record);
+    /// Fold the current peak into the running phases and stop tracking 'record'
+    void endPeak(Record &record);
+    /// Raise the peak of the running phases and of the process to 'peakKB'; requires mtx
+    void foldPeak(uint64_t peakKB);
+
+    std::chrono::steady_clock::time_point start;
+    mutable std::mutex mtx;
+    std::vector<Record> records;
+    std::vector<Record *> runningPhases;
+    uint64_t processPeakKB = 0;   // peak RSS before the last reset
+    bool peakResettable = true;   // false if /proc/self/clear_refs is not writable, making phase peaks cumulative
+    bool countersEnabled = false;
+};
+
+
+/**
+ * A phase timed from construction to stop() or destruction, whichever comes first
+ */
+class ProfilePhase
+{
+public:
+    explicit ProfilePhase(std::string name, std::string detail = "");
+
+    ~ProfilePhase()
+    { stop(); }
+
+    ProfilePhase(const ProfilePhase &) = delete;
+    ProfilePhase &operator=(const ProfilePhase &) = delete;
+
+    /// End the phase and record it; later calls do nothing
+    void stop();
+
+private:
+    Profiler::Record record;
+    bool running = true;
+};
+
+#endif //ANSWERS_PROFILER_H
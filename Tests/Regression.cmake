@@ -0,0 +1,69 @@
+# Correctness and performance regression tests over the Test-Cases of each assignment.
+#
+# Each test compiles one Test-Cases/*.c file to LLVM IR, runs a tool on it with -profile-trace, compares the
+# tool's outputs with Test-Cases/golden/, appends the wall time and peak RSS to a history file and fails if
+# the run is slower than the recent history by more than REGRESSION_SLOWDOWN_PERCENT. A case without goldens
+# fails until they are created with REGRESSION_UPDATE_GOLDEN.
+#
+#   ctest --test-dir build                          run everything
+#   ctest --test-dir build -L cflr                  run one tool's tests
+#   cmake -DREGRESSION_UPDATE_GOLDEN=ON build       then ctest: rewrite the goldens from the current outputs
+
+set(REGRESSION_UPDATE_GOLDEN OFF CACHE BOOL "Overwrite the golden outputs instead of comparing against them")
+set(REGRESSION_HISTORY "${CMAKE_BINARY_DIR}/regression-history.tsv" CACHE FILEPATH
+        "File collecting the wall time and peak RSS of every test run")
+set(REGRESSION_SLOWDOWN_PERCENT 50 CACHE STRING
+        "Fail when a run is slower than the median of recent runs by more than this many percent")
+set(REGRESSION_MIN_MS 100 CACHE STRING "Runs faster than this many milliseconds are never reported as slow")
+set(REGRESSION_WINDOW 5 CACHE STRING "Number of recent runs the slowdown is measured against")
+
+find_program(REGRESSION_CLANG clang HINTS ${LLVM_TOOLS_BINARY_DIR} NO_DEFAULT_PATH)
+find_program(REGRESSION_CLANG clang)
+
+#
+# add_regression_tests(<tool> [NAME <name>] ARGS <tool args...> OUTPUTS <suffixes...>)
+#
+# Adds one test per Test-Cases/*.c file of the calling directory. A tool run on <case>.ll must write
+# <case>.ll<suffix> into its working directory or next to its input for every suffix in OUTPUTS.
+# NAME (default: the tool) prefixes the test names and selects the golden directory, Test-Cases/golden for
+# the tool itself and Test-Cases/golden/<name> otherwise, so one tool can be tested with several ARGS.
+#
+function(add_regression_tests tool)
+    cmake_parse_arguments(REG "" "NAME" "ARGS;OUTPUTS" ${ARGN})
+    if (NOT REGRESSION_CLANG)
+        message(STATUS "clang not found, skipping the regression tests of ${tool}")
+        return()
+    endif ()
+    set(name ${tool})
+    set(golden_dir ${CMAKE_CURRENT_SOURCE_DIR}/Test-Cases/golden)
+    if (REG_NAME AND NOT REG_NAME STREQUAL tool)
+        set(name ${REG_NAME})
+        set(golden_dir ${golden_dir}/${REG_NAME})
+    endif ()
+
+    file(GLOB cases RELATIVE ${CMAKE_CURRENT_SOURCE_DIR}/Test-Cases ${CMAKE_CURRENT_SOURCE_DIR}/Test-Cases/*.c)
+    # Lists are passed to the driver with '|' separators, since ';' would split the command line
+    string(REPLACE ";" "|" tool_args "${REG_ARGS}")
+    string(REPLACE ";" "|" outputs "${REG_OUTPUTS}")
+    foreach (case_file ${cases})
+        get_filename_component(case ${case_file} NAME_WE)
+        add_test(NAME ${name}/${case}
+                COMMAND ${CMAKE_COMMAND}
+                -DTEST_NAME=${name}/${case}
+                -DTOOL=$<TARGET_FILE:${tool}>
+                -DTOOL_ARGS=${tool_args}
+                -DCLANG=${REGRESSION_CLANG}
+                -DSOURCE=${CMAKE_CURRENT_SOURCE_DIR}/Test-Cases/${case_file}
+                -DWORK_DIR=${CMAKE_CURRENT_BINARY_DIR}/regression/${name}/${case}
+                -DOUTPUTS=${outputs}
+                -DGOLDEN_DIR=${golden_dir}
+                -DUPDATE_GOLDEN=${REGRESSION_UPDATE_GOLDEN}
+                -DHISTORY=${REGRESSION_HISTORY}
+                -DSLOWDOWN_PERCENT=${REGRESSION_SLOWDOWN_PERCENT}
+                -DMIN_MS=${REGRESSION_MIN_MS}
+                -DWINDOW=${REGRESSION_WINDOW}
+                -P ${CMAKE_SOURCE_DIR}/Tests/RunRegression.cmake)
+        # Tests share the history file, and timings are only comparable when runs do not compete for cores
+        set_tests_properties(${name}/${case} PROPERTIES LABELS ${tool} RUN_SERIAL TRUE)
+    endforeach ()
+endfunction()
@@ -0,0 +1,98 @@
+# Driver of one regression test, run with cmake -P; the parameters are set by add_regression_tests()
+
+string(REPLACE "|" ";" TOOL_ARGS "${TOOL_ARGS}")
+string(REPLACE "|" ";" OUTPUTS "${OUTPUTS}")
+get_filename_component(case ${SOURCE} NAME_WE)
+file(MAKE_DIRECTORY ${WORK_DIR})
+set(ir ${WORK_DIR}/${case}.ll)
+set(profile ${WORK_DIR}/${case}.profile.json)
+
+# Compile the test case
+execute_process(COMMAND ${CLANG} -S -c -g -fno-discard-value-names -emit-llvm ${SOURCE} -o ${ir}
+        RESULT_VARIABLE rc ERROR_VARIABLE err)
+if (NOT rc EQUAL 0)
+    message(FATAL_ERROR "compiling ${SOURCE} failed:\n${err}")
+endif ()
+
+# Run the tool; stale outputs are removed first so that a missing output cannot pass
+foreach (suffix ${OUTPUTS})
+    file(REMOVE ${WORK_DIR}/${case}.ll${suffix})
+endforeach ()
+file(REMOVE ${profile})
+execute_process(COMMAND ${TOOL} ${TOOL_ARGS} -profile-trace=${profile} ${ir}
+        WORKING_DIRECTORY ${WORK_DIR} RESULT_VARIABLE rc OUTPUT_VARIABLE out ERROR_VARIABLE out)
+if (NOT rc EQUAL 0)
+    message(FATAL_ERROR "${TOOL} failed on ${ir} (${rc}):\n${out}")
+endif ()
+
+# Compare with, or update, the golden outputs
+set(failed "")
+foreach (suffix ${OUTPUTS})
+    set(output ${WORK_DIR}/${case}.ll${suffix})
+    set(golden ${GOLDEN_DIR}/${case}${suffix})
+    if (NOT EXISTS ${output})
+        string(APPEND failed "  missing output ${output}\n")
+    elseif (UPDATE_GOLDEN)
+        file(MAKE_DIRECTORY ${GOLDEN_DIR})
+        file(COPY_FILE ${output} ${golden})
+        message(STATUS "updated ${golden}")
+    elseif (NOT EXISTS ${golden})
+        string(APPEND failed "  no golden ${golden}; review the output and configure with -DREGRESSION_UPDATE_GOLDEN=ON to create it\n")
+    else ()
+        execute_process(COMMAND ${CMAKE_COMMAND} -E compare_files ${output} ${golden} RESULT_VARIABLE rc)
+        if (NOT rc EQUAL 0)
+            string(APPEND failed "  ${output} differs from ${golden}\n")
+        endif ()
+    endif ()
+endforeach ()
+
+# Record the run; the baseline is the median wall time of the last WINDOW runs of this test
+if (NOT EXISTS ${profile})
+    message(FATAL_ERROR "${TOOL} wrote no profile ${profile}")
+endif ()
+file(READ ${profile} json)
+string(JSON wall_ms GET "${json}" otherData wall_ms)
+string(JSON peak_rss_kb GET "${json}" otherData peak_rss_kb)
+string(REGEX REPLACE "\\..*$" "" wall_ms "${wall_ms}")
+
+file(LOCK ${HISTORY}.lock GUARD PROCESS)
+set(recent "")
+if (EXISTS ${HISTORY})
+    file(STRINGS ${HISTORY} lines)
+    foreach (line ${lines})
+        string(REPLACE "\t" ";" fields "${line}")
+        list(LENGTH fields num_fields)
+        if (num_fields EQUAL 4)
+            list(GET fields 1 name)
+            list(GET fields 2 ms)
+            if (name STREQUAL TEST_NAME)
+                list(APPEND recent ${ms})
+            endif ()
+        endif ()
+    endforeach ()
+endif ()
+string(TIMESTAMP now "%Y-%m-%dT%H:%M:%S")
+file(APPEND ${HISTORY} "${now}\t${TEST_NAME}\t${wall_ms}\t${peak_rss_kb}\n")
+file(LOCK ${HISTORY}.lock RELEASE)
+
+list(LENGTH recent num_recent)
+if (num_recent GREATER WINDOW)
+    math(EXPR first "${num_recent} - ${WINDOW}")
+    list(SUBLIST recent ${first} ${WINDOW} recent)
+    set(num_recent ${WINDOW})
+endif ()
+message(STATUS "${TEST_NAME}: ${wall_ms} ms, peak RSS ${peak_rss_kb} KiB")
+if (num_recent GREATER 0)
+    list(SORT recent COMPARE NATURAL)
+    math(EXPR middle "${num_recent} / 2")
+    list(GET recent ${middle} median)
+    math(EXPR limit "${median} * (100 + ${SLOWDOWN_PERCENT}) / 100")
+    message(STATUS "${TEST_NAME}: median of the last ${num_recent} runs: ${median} ms")
+    if (wall_ms GREATER limit AND wall_ms GREATER_EQUAL MIN_MS)
+        string(APPEND failed "  ${wall_ms} ms is more than ${SLOWDOWN_PERCENT}% slower than the median ${median} ms\n")
+    endif ()
+endif ()
+
+if (failed)
+    message(FATAL_ERROR "${TEST_NAME} failed:\n${failed}")
+endif ()